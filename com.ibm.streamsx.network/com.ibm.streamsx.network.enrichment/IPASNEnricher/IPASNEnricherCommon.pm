@@ -45,6 +45,14 @@ sub init($) {
 	$::isVector = isVector($::inputIPAttrParamSPLType);
 	$::isMatrix = isMatrix($::inputIPAttrParamSPLType);
 	
+	## the type of a single address in the input attribute
+	$::inputIPAttrElementSPLType = $::inputIPAttrParamSPLType;
+	if($::isVector) {
+		$::inputIPAttrElementSPLType = SPL::CodeGen::Type::getElementType($::inputIPAttrElementSPLType);
+	} elsif($::isMatrix) {
+		$::inputIPAttrElementSPLType = SPL::CodeGen::Type::getElementType(SPL::CodeGen::Type::getElementType($::inputIPAttrElementSPLType));
+	}
+	
 #	SPL::CodeGen::warnln($::inputIPAttrParamSPLType);
 #	SPL::CodeGen::warnln("isScalar=" . $::isScalar . ", isVector=" . $::isVector . ", isMatrix=" . $::isMatrix);
 	
@@ -108,32 +116,16 @@ sub validate($) {
 	unshift @INC, dirname ($model->getContext()->getOperatorDirectory()) . "/../impl/nl/include";
 	require NetworkResources;
 
-	## validate that the inputIPAttr parameter contains an attribute with one of the following types:
-	## - rstring
-	## - list<rstring>
-	## - list<list<rstring>>
-	if($::isScalar && !SPL::CodeGen::Type::isRString($::inputIPAttrParamSPLType))
-	{
-		SPL::CodeGen::exitln(NetworkResources::NETWORK_ATTRIBUTE_PARAMETER_HAS_WRONG_TYPE("inputIPAttr", "'rstring', 'list<rstring>' or 'list<list<rstring>>'", $::inputIPAttrParamSPLType));
-	}
-	
-	if($::isVector)
-	{
-		my $elemType = SPL::CodeGen::Type::getElementType($::inputIPAttrParamSPLType);
-		if(!SPL::CodeGen::Type::isRString($elemType))
-		{
-			SPL::CodeGen::exitln(NetworkResources::NETWORK_ATTRIBUTE_PARAMETER_HAS_WRONG_TYPE("inputIPAttr", "'rstring', 'list<rstring>' or 'list<list<rstring>>'", $::inputIPAttrParamSPLType));
-		}
-	}
-	
-	if($::isMatrix)
+	## validate that the inputIPAttr parameter contains an attribute with one of the following types,
+	## or a list or list of lists of them:
+	## - rstring (IPv4 or IPv6 address string)
+	## - uint32 (IPv4 address in host byte order)
+	## - list<uint8>[16] (IPv6 address in network byte order)
+	if(!SPL::CodeGen::Type::isRString($::inputIPAttrElementSPLType) && 
+	   !SPL::CodeGen::Type::isUint32($::inputIPAttrElementSPLType) && 
+	   !isIPv6Bytes($::inputIPAttrElementSPLType))
 	{
-		my $elemType = SPL::CodeGen::Type::getElementType($::inputIPAttrParamSPLType);
-		$elemType = SPL::CodeGen::Type::getElementType($elemType);
-		if(!SPL::CodeGen::Type::isRString($elemType))
-		{
-			SPL::CodeGen::exitln(NetworkResources::NETWORK_ATTRIBUTE_PARAMETER_HAS_WRONG_TYPE("inputIPAttr", "'rstring', 'list<rstring>' or 'list<list<rstring>>'", $::inputIPAttrParamSPLType));
-		}
+		SPL::CodeGen::exitln(NetworkResources::NETWORK_ATTRIBUTE_PARAMETER_HAS_WRONG_TYPE("inputIPAttr", "'rstring', 'uint32', 'list<uint8>[16]', or a list or list of lists of them", $::inputIPAttrParamSPLType));
 	}
 
 	if(defined $::inputPort1) {
@@ -161,7 +153,7 @@ sub isScalar($) {
 		$elemType = (SPL::CodeGen::Type::getAttributeTypes($elemType))[0];
 	}
 	
-	return !SPL::CodeGen::Type::isList($elemType); 
+	return !SPL::CodeGen::Type::isList($elemType) || isIPv6Bytes($elemType); 
 }
 1;
 
@@ -172,10 +164,10 @@ sub isVector($) {
 		$elemType = (SPL::CodeGen::Type::getAttributeTypes($elemType))[0];
 	}
 	
-	if(SPL::CodeGen::Type::isList($elemType)) {
+	if(SPL::CodeGen::Type::isList($elemType) && !isIPv6Bytes($elemType)) {
 		# element type should NOT be another list (otherwise it is a matrix)
 		$elemType = SPL::CodeGen::Type::getElementType($elemType);
-		return !SPL::CodeGen::Type::isList($elemType);
+		return !SPL::CodeGen::Type::isList($elemType) || isIPv6Bytes($elemType);
 	}
 	
 	return 0;
@@ -189,12 +181,20 @@ sub isMatrix($) {
 		$elemType = (SPL::CodeGen::Type::getAttributeTypes($elemType))[0];
 	}
 	
-	if(SPL::CodeGen::Type::isList($elemType)) {
+	if(SPL::CodeGen::Type::isList($elemType) && !isIPv6Bytes($elemType)) {
 		# element type should be another list
 		my $elemType = SPL::CodeGen::Type::getElementType($elemType);
-		return SPL::CodeGen::Type::isList($elemType); 
+		return SPL::CodeGen::Type::isList($elemType) && !isIPv6Bytes($elemType); 
 	}
 	
 	return 0;
 }
-1;
\ No newline at end of file
+1;
+
+## an IPv6 address in network byte order is a list<uint8>[16], which counts
+## as a single address rather than as a list
+sub isIPv6Bytes($) {
+	my ($type) = @_;
+	return $type eq "list<uint8>[16]";
+}
+1;
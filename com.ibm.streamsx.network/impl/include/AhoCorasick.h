@@ -0,0 +1,236 @@
+/*********************************************************************
+ * Copyright (C) 2026 International Business Machines Corporation
+ * All Rights Reserved
+ ********************************************************************/
+
+#ifndef AHO_CORASICK_H_
+#define AHO_CORASICK_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <algorithm>
+#include <vector>
+#include <tr1/unordered_map>
+
+namespace com { namespace ibm { namespace streamsx { namespace network {
+
+// This class matches text against a set of literal strings with the
+// Aho-Corasick algorithm, so the cost of a match is linear in the length
+// of the text no matter how many strings are in the set.
+//
+// Strings are add()ed one at a time and then compile() builds the failure
+// links.  The automaton keeps the trie edges in one sorted array per
+// state rather than a full 256 entry row, so memory stays proportional to
+// the total length of the strings; the root state, which is revisited the
+// most, gets a full row.
+//
+// The match functions are const and may be called from any number of
+// threads at once after compile().
+class AhoCorasick {
+public:
+    AhoCorasick() {
+        clear();
+    }
+
+    // Removes all strings.
+    void clear() {
+        buildEdges_.clear();
+        terminal_.assign(1, 0);
+        output_.clear();
+        fail_.clear();
+        edgeStart_.clear();
+        edgeBytes_.clear();
+        edgeTargets_.clear();
+        std::fill(root_, root_ + 256, 0);
+        patternCount_ = 0;
+        compiled_ = false;
+    }
+
+    // Adds a string to the set.  compile() must be called before the new
+    // string is matched.
+    void add(const char *pattern, size_t len) {
+        if(buildEdges_.empty() && !edgeBytes_.empty()) restoreEdges();
+        uint32_t state = ROOT;
+        for(size_t i = 0; i < len; ++i) {
+            uint64_t key = edgeKey(state, static_cast<uint8_t>(pattern[i]));
+            std::tr1::unordered_map<uint64_t, uint32_t>::const_iterator it = buildEdges_.find(key);
+            if(it != buildEdges_.end()) {
+                state = it->second;
+            } else {
+                uint32_t next = static_cast<uint32_t>(terminal_.size());
+                terminal_.push_back(0);
+                buildEdges_[key] = next;
+                state = next;
+            }
+        }
+        terminal_[state] = 1;
+        ++patternCount_;
+        compiled_ = false;
+    }
+
+    // Flattens the trie edges and computes the failure links.
+    void compile() {
+        size_t stateCount = terminal_.size();
+
+        // Flatten the edges into per-state sorted arrays.
+        std::vector<uint64_t> keys;
+        keys.reserve(buildEdges_.size());
+        for(std::tr1::unordered_map<uint64_t, uint32_t>::const_iterator it = buildEdges_.begin(); it != buildEdges_.end(); ++it) {
+            keys.push_back(it->first);
+        }
+        std::sort(keys.begin(), keys.end());
+
+        edgeStart_.assign(stateCount + 1, 0);
+        edgeBytes_.resize(keys.size());
+        edgeTargets_.resize(keys.size());
+        for(size_t i = 0; i < keys.size(); ++i) {
+            edgeBytes_[i] = static_cast<uint8_t>(keys[i] & 0xff);
+            edgeTargets_[i] = buildEdges_[keys[i]];
+            ++edgeStart_[(keys[i] >> 8) + 1];
+        }
+        for(size_t s = 0; s < stateCount; ++s) {
+            edgeStart_[s + 1] += edgeStart_[s];
+        }
+
+        // Compute failure links breadth first, so a state's failure target
+        // is always finished before the state itself.
+        fail_.assign(stateCount, ROOT);
+        output_.assign(terminal_.begin(), terminal_.end());
+        std::fill(root_, root_ + 256, ROOT);
+
+        std::vector<uint32_t> queue;
+        queue.reserve(stateCount);
+        for(uint32_t e = edgeStart_[ROOT]; e < edgeStart_[ROOT + 1]; ++e) {
+            root_[edgeBytes_[e]] = edgeTargets_[e];
+            queue.push_back(edgeTargets_[e]);
+        }
+
+        for(size_t head = 0; head < queue.size(); ++head) {
+            uint32_t state = queue[head];
+            output_[state] |= output_[fail_[state]];
+            for(uint32_t e = edgeStart_[state]; e < edgeStart_[state + 1]; ++e) {
+                uint32_t child = edgeTargets_[e];
+                fail_[child] = step(fail_[state], edgeBytes_[e]);
+                queue.push_back(child);
+            }
+        }
+
+        // The root can match too, if an empty string was added.
+        output_[ROOT] = terminal_[ROOT];
+
+        // The edge map is not needed for matching, so free it, rather than
+        // just clearing it, which would keep its buckets.
+        std::tr1::unordered_map<uint64_t, uint32_t>().swap(buildEdges_);
+
+        compiled_ = true;
+    }
+
+    // Returns true if no strings have been added since the last clear().
+    bool empty() const {
+        return (patternCount_ == 0);
+    }
+
+    // Returns the number of strings added since the last clear().
+    size_t size() const {
+        return patternCount_;
+    }
+
+    // Returns true if any string in the set occurs anywhere in the text.
+    bool matchSubstring(const char *text, size_t len) const {
+        if(!compiled_) return false;
+        if(output_[ROOT]) return true;
+
+        uint32_t state = ROOT;
+        for(size_t i = 0; i < len; ++i) {
+            state = step(state, static_cast<uint8_t>(text[i]));
+            if(output_[state]) return true;
+        }
+        return false;
+    }
+
+    // Returns true if the text ends with any string in the set.
+    bool matchSuffix(const char *text, size_t len) const {
+        if(!compiled_) return false;
+
+        uint32_t state = ROOT;
+        for(size_t i = 0; i < len; ++i) {
+            state = step(state, static_cast<uint8_t>(text[i]));
+        }
+        return (output_[state] != 0);
+    }
+
+    // Returns true if the text is equal to any string in the set.  This
+    // only follows trie edges, never failure links.
+    bool matchExact(const char *text, size_t len) const {
+        if(!compiled_) return false;
+
+        uint32_t state = ROOT;
+        for(size_t i = 0; i < len; ++i) {
+            state = child(state, static_cast<uint8_t>(text[i]));
+            if(state == NONE) return false;
+        }
+        return (terminal_[state] != 0);
+    }
+
+private:
+    enum { ROOT = 0 };
+    static const uint32_t NONE = 0xffffffff;
+
+    static uint64_t edgeKey(uint32_t state, uint8_t byte) {
+        return (static_cast<uint64_t>(state) << 8) | byte;
+    }
+
+    // Returns the trie child of 'state' for 'byte', or NONE.
+    uint32_t child(uint32_t state, uint8_t byte) const {
+        const uint8_t *first = edgeBytes_.data() + edgeStart_[state];
+        const uint8_t *last = edgeBytes_.data() + edgeStart_[state + 1];
+        const uint8_t *found = std::lower_bound(first, last, byte);
+        if(found == last || *found != byte) return NONE;
+        return edgeTargets_[found - edgeBytes_.data()];
+    }
+
+    // Returns the automaton state after reading 'byte' in 'state'.
+    uint32_t step(uint32_t state, uint8_t byte) const {
+        while(state != ROOT) {
+            uint32_t next = child(state, byte);
+            if(next != NONE) return next;
+            state = fail_[state];
+        }
+        return root_[byte];
+    }
+
+    // Rebuilds the edge map from the flattened edges, when a string is
+    // added after compile() has freed it.
+    void restoreEdges() {
+        for(uint32_t state = 0; state + 1 < edgeStart_.size(); ++state) {
+            for(uint32_t e = edgeStart_[state]; e < edgeStart_[state + 1]; ++e) {
+                buildEdges_[edgeKey(state, edgeBytes_[e])] = edgeTargets_[e];
+            }
+        }
+    }
+
+    // Edges by (state << 8 | byte) while strings are being added, freed by
+    // compile().
+    std::tr1::unordered_map<uint64_t, uint32_t> buildEdges_;
+
+    // Per state: whether a string ends here, whether a string ends here or
+    // at any state on its failure chain, and its failure link.
+    std::vector<uint8_t> terminal_;
+    std::vector<uint8_t> output_;
+    std::vector<uint32_t> fail_;
+
+    // Trie edges of state s are edgeBytes_/edgeTargets_[edgeStart_[s] .. edgeStart_[s+1]).
+    std::vector<uint32_t> edgeStart_;
+    std::vector<uint8_t> edgeBytes_;
+    std::vector<uint32_t> edgeTargets_;
+
+    // Full transition row for the root state.
+    uint32_t root_[256];
+
+    size_t patternCount_;
+    bool compiled_;
+};
+
+} } } }
+
+#endif
@@ -0,0 +1,199 @@
+/*********************************************************************
+ * Copyright (C) 2026 International Business Machines Corporation
+ * All Rights Reserved
+ ********************************************************************/
+
+#ifndef DOMAIN_SUFFIX_TRIE_H_
+#define DOMAIN_SUFFIX_TRIE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <algorithm>
+#include <vector>
+#include <tr1/unordered_map>
+
+namespace com { namespace ibm { namespace streamsx { namespace network {
+
+// This class holds a set of public suffix rules (TLDs such as "com" or
+// "co.uk") and finds the longest public suffix of a domain name.  It
+// understands the rule syntax of the Public Suffix List: a rule may be a
+// plain suffix ("co.uk"), a wildcard ("*.ck", any label under "ck" is a
+// public suffix), or an exception ("!www.ck", "www.ck" is not a public
+// suffix even though "*.ck" says it is).  Empty lines and "//" comments
+// are ignored, so the list file can be fed in line by line.
+//
+// The rules are stored in a byte trie keyed by the rule reversed ("kc.www"
+// for "www.ck"), so a domain name is matched by walking it once from right
+// to left, directly on its bytes and without any copies, lowercasing as it
+// goes.
+//
+// Rules are add()ed one at a time and then compile() flattens the trie into
+// per-node sorted edge arrays.  findSuffix() is const and may be called from
+// any number of threads at once after compile().
+class DomainSuffixTrie {
+public:
+    static const size_t NPOS = static_cast<size_t>(-1);
+
+    DomainSuffixTrie() {
+        clear();
+    }
+
+    // Removes all rules.
+    void clear() {
+        buildEdges_.clear();
+        flags_.assign(1, 0);
+        edgeStart_.clear();
+        edgeBytes_.clear();
+        edgeTargets_.clear();
+        ruleCount_ = 0;
+    }
+
+    // Adds a rule.  compile() must be called before the new rule is used.
+    // Returns false if the line was empty or a comment.
+    bool add(const char *rule, size_t len) {
+        // trim surrounding white space, e.g. a '\r' from a DOS format file
+        while(len > 0 && isSpace(rule[len - 1])) --len;
+        while(len > 0 && isSpace(rule[0])) { ++rule; --len; }
+
+        if(len == 0) return false;
+        if(len >= 2 && rule[0] == '/' && rule[1] == '/') return false;
+
+        uint8_t flag = TERMINAL;
+        if(rule[0] == '!') {
+            flag = EXCEPTION;
+            ++rule; --len;
+        } else if(rule[0] == '*' && (len == 1 || rule[1] == '.')) {
+            flag = WILDCARD;
+            rule += (len == 1) ? 1 : 2;
+            len -= (len == 1) ? 1 : 2;
+        }
+
+        uint32_t node = ROOT;
+        for(size_t i = len; i > 0; --i) {
+            uint64_t key = edgeKey(node, toLower(rule[i - 1]));
+            std::tr1::unordered_map<uint64_t, uint32_t>::const_iterator it = buildEdges_.find(key);
+            if(it != buildEdges_.end()) {
+                node = it->second;
+            } else {
+                uint32_t next = static_cast<uint32_t>(flags_.size());
+                flags_.push_back(0);
+                buildEdges_[key] = next;
+                node = next;
+            }
+        }
+        flags_[node] |= flag;
+        ++ruleCount_;
+        return true;
+    }
+
+    // Flattens the trie edges into per-node sorted arrays.
+    void compile() {
+        std::vector<uint64_t> keys;
+        keys.reserve(buildEdges_.size());
+        for(std::tr1::unordered_map<uint64_t, uint32_t>::const_iterator it = buildEdges_.begin(); it != buildEdges_.end(); ++it) {
+            keys.push_back(it->first);
+        }
+        std::sort(keys.begin(), keys.end());
+
+        size_t nodeCount = flags_.size();
+        edgeStart_.assign(nodeCount + 1, 0);
+        edgeBytes_.resize(keys.size());
+        edgeTargets_.resize(keys.size());
+        for(size_t i = 0; i < keys.size(); ++i) {
+            edgeBytes_[i] = static_cast<uint8_t>(keys[i] & 0xff);
+            edgeTargets_[i] = buildEdges_[keys[i]];
+            ++edgeStart_[(keys[i] >> 8) + 1];
+        }
+        for(size_t n = 0; n < nodeCount; ++n) {
+            edgeStart_[n + 1] += edgeStart_[n];
+        }
+    }
+
+    // Returns the number of rules added since the last clear().
+    size_t size() const {
+        return ruleCount_;
+    }
+
+    // Returns the offset in 'name' at which its longest public suffix starts,
+    // or NPOS if no rule matches.
+    size_t findSuffix(const char *name, size_t len) const {
+        if(edgeStart_.empty()) return NPOS;
+
+        size_t best = NPOS;
+        uint32_t labelNode = ROOT;   // trie node for the labels matched so far
+        size_t labelEnd = len;
+
+        while(true) {
+            size_t labelStart = labelEnd;
+            while(labelStart > 0 && name[labelStart - 1] != '.') --labelStart;
+
+            // a wildcard rule makes any label below the suffix matched so far a public suffix
+            if(flags_[labelNode] & WILDCARD) best = labelStart;
+
+            uint32_t node = labelNode;
+            if(node != ROOT) node = child(node, '.');
+            for(size_t i = labelEnd; node != NONE && i > labelStart; --i) {
+                node = child(node, toLower(name[i - 1]));
+            }
+            if(node == NONE) break;
+
+            // an exception rule wins over everything, its public suffix is the rule without its first label
+            if(flags_[node] & EXCEPTION) return (labelEnd == len) ? NPOS : labelEnd + 1;
+
+            if(flags_[node] & TERMINAL) best = labelStart;
+
+            if(labelStart == 0) break;
+            labelNode = node;
+            labelEnd = labelStart - 1;
+        }
+
+        return best;
+    }
+
+private:
+    enum { ROOT = 0 };
+    static const uint32_t NONE = 0xffffffff;
+
+    // node flags
+    static const uint8_t TERMINAL = 1;
+    static const uint8_t WILDCARD = 2;
+    static const uint8_t EXCEPTION = 4;
+
+    static uint8_t toLower(char c) {
+        return (c >= 'A' && c <= 'Z') ? static_cast<uint8_t>(c - 'A' + 'a') : static_cast<uint8_t>(c);
+    }
+
+    static bool isSpace(char c) {
+        return (c == ' ' || c == '\t' || c == '\r' || c == '\n');
+    }
+
+    static uint64_t edgeKey(uint32_t node, uint8_t byte) {
+        return (static_cast<uint64_t>(node) << 8) | byte;
+    }
+
+    // Returns the child of 'node' for 'byte', or NONE.
+    uint32_t child(uint32_t node, uint8_t byte) const {
+        const uint8_t *first = edgeBytes_.data() + edgeStart_[node];
+        const uint8_t *last = edgeBytes_.data() + edgeStart_[node + 1];
+        const uint8_t *found = std::lower_bound(first, last, byte);
+        if(found == last || *found != byte) return NONE;
+        return edgeTargets_[found - edgeBytes_.data()];
+    }
+
+    // Edges by (node << 8 | byte) while rules are being added.
+    std::tr1::unordered_map<uint64_t, uint32_t> buildEdges_;
+
+    // Rule flags of each node.
+    std::vector<uint8_t> flags_;
+
+    // Edges of node n are edgeBytes_/edgeTargets_[edgeStart_[n] .. edgeStart_[n+1]).
+    std::vector<uint32_t> edgeStart_;
+    std::vector<uint8_t> edgeBytes_;
+    std::vector<uint32_t> edgeTargets_;
+
+    size_t ruleCount_;
+};
+
+} } } }
+
+#endif
@@ -0,0 +1,558 @@
+/*********************************************************************
+ * Copyright (C) 2026 International Business Machines Corporation
+ * All Rights Reserved
+ ********************************************************************/
+
+#ifndef GEO_SNAPSHOT_H_
+#define GEO_SNAPSHOT_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <tr1/unordered_map>
+
+#include "IPRangeTable.h"
+
+namespace com { namespace ibm { namespace streamsx { namespace network {
+
+// A geography snapshot is a binary image of the MaxMind GeoIP2 or GeoLite2
+// City database, laid out so that it can be mapped read-only from a file
+// and searched in place, without parsing anything.  All PEs on a host that
+// map the same snapshot file share its pages.
+//
+// The image starts with a GeoSnapshotHeader, followed by these sections,
+// each starting on an 8 byte boundary:
+//
+//   locations    GeoSnapshotLocation[locationCount]
+//   IPv4 ranges  GeoSnapshotIPv4Range[ipv4Count], sorted by start address
+//   IPv6 ranges  GeoSnapshotIPv6Range[ipv6Count], sorted by start address
+//   strings      NUL terminated strings, starting with an empty one
+//
+// Strings are referred to by their offset in the string section, and each
+// distinct string is stored once.  Ranges refer to their location by its
+// index in the location table.  Numbers are in host byte order, so a
+// snapshot is only usable on hosts with the same byte order as the one
+// that wrote it.
+
+enum {
+    GEO_SNAPSHOT_VERSION = 1,
+    GEO_SNAPSHOT_BYTE_ORDER = 0x01020304
+};
+
+// The string fields of a location, in the column order of the MaxMind
+// locations file.
+enum GeoLocationField {
+    GEO_LOCATION_ID,
+    GEO_CONTINENT_CODE,
+    GEO_CONTINENT_NAME,
+    GEO_COUNTRY_CODE,
+    GEO_COUNTRY_NAME,
+    GEO_SUBDIVISION1_CODE,
+    GEO_SUBDIVISION1_NAME,
+    GEO_SUBDIVISION2_CODE,
+    GEO_SUBDIVISION2_NAME,
+    GEO_CITY_NAME,
+    GEO_METRO_CODE,
+    GEO_TIMEZONE,
+    GEO_IN_EU,
+    GEO_LOCATION_FIELDS
+};
+
+struct GeoSnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint64_t fileSize;
+    uint64_t locationOffset;
+    uint64_t locationCount;
+    uint64_t ipv4Offset;
+    uint64_t ipv4Count;
+    uint64_t ipv6Offset;
+    uint64_t ipv6Count;
+    uint64_t stringOffset;
+    uint64_t stringSize;
+};
+
+struct GeoSnapshotLocation {
+    uint32_t field[GEO_LOCATION_FIELDS];    // string offsets
+};
+
+// The range records follow the IPRangeTable.h conventions, so they can be
+// searched with findIPRange().
+struct GeoSnapshotIPv4Range {
+    uint32_t start_ip[1];
+    uint32_t end_ip[1];
+    uint32_t prefixLength;
+    uint32_t location;      // location index
+    uint32_t postalCode;    // string offset
+    uint32_t reserved;
+    double latitude;
+    double longitude;
+    double radius;
+};
+
+struct GeoSnapshotIPv6Range {
+    uint32_t start_ip[4];
+    uint32_t end_ip[4];
+    uint32_t prefixLength;
+    uint32_t location;      // location index
+    uint32_t postalCode;    // string offset
+    uint32_t reserved;
+    double latitude;
+    double longitude;
+    double radius;
+};
+
+static const char GEO_SNAPSHOT_MAGIC[8] = { 'G', 'E', 'O', 'S', 'N', 'A', 'P', '\0' };
+
+
+class GeoSnapshot;
+
+// This class collects locations and ranges, e.g. while the CSV files are
+// parsed, and builds a snapshot image from them.  The locations and each
+// address family can be cleared and added again separately, so that one
+// file can be reloaded without parsing the others again: assign() the
+// current snapshot, clear the part the file replaces, and add it again.
+//
+// Ranges name their location by its ID and are matched up with the
+// locations when the image is built, so the files can be added in any
+// order.
+class GeoSnapshotWriter {
+public:
+    GeoSnapshotWriter() {
+        clear();
+    }
+
+    void clear() {
+        strings_.assign(1, '\0');
+        stringIndex_.clear();
+        clearLocations();
+        clearIPv4Ranges();
+        clearIPv6Ranges();
+    }
+
+    // Replaces everything with the contents of a snapshot.
+    void assign(const GeoSnapshot &snapshot);
+
+    void clearLocations() {
+        locations_.clear();
+        locationIndex_.clear();
+    }
+
+    void clearIPv4Ranges() {
+        ipv4_.clear();
+    }
+
+    void clearIPv6Ranges() {
+        ipv6_.clear();
+    }
+
+    size_t locationCount() const { return locations_.size(); }
+    size_t ipv4RangeCount() const { return ipv4_.size(); }
+    size_t ipv6RangeCount() const { return ipv6_.size(); }
+
+    // Adds a location.  Returns false if a location with the same ID has
+    // already been added, in which case the first one is kept.
+    bool addLocation(const std::string (&fields)[GEO_LOCATION_FIELDS]) {
+        uint32_t id = addString(fields[GEO_LOCATION_ID]);
+        if(locationIndex_.find(id) != locationIndex_.end()) return false;
+
+        GeoSnapshotLocation location;
+        location.field[GEO_LOCATION_ID] = id;
+        for(size_t f = GEO_LOCATION_ID + 1; f < GEO_LOCATION_FIELDS; ++f) {
+            location.field[f] = addString(fields[f]);
+        }
+        locationIndex_[id] = static_cast<uint32_t>(locations_.size());
+        locations_.push_back(location);
+        return true;
+    }
+
+    // Returns true if a location with this ID has been added.
+    bool hasLocation(const std::string &id) const {
+        std::tr1::unordered_map<std::string, uint32_t>::const_iterator s = stringIndex_.find(id);
+        return (s != stringIndex_.end() && locationIndex_.find(s->second) != locationIndex_.end());
+    }
+
+    // Adds an IPv4 subnet, given its address and mask in host byte order.
+    void addIPv4Range(uint32_t address, uint32_t mask, const std::string &locationID, const std::string &postalCode,
+                      double latitude, double longitude, double radius) {
+        GeoSnapshotIPv4Range range;
+        memset(&range, 0, sizeof(range));
+        range.start_ip[0] = address & mask;
+        range.end_ip[0] = address | ~mask;
+        range.prefixLength = __builtin_popcount(mask);
+        range.location = addString(locationID);
+        range.postalCode = addString(postalCode);
+        range.latitude = latitude;
+        range.longitude = longitude;
+        range.radius = radius;
+        ipv4_.push_back(range);
+    }
+
+    // Adds an IPv6 subnet, given its address and mask as sixteen bytes in
+    // network byte order.
+    void addIPv6Range(const uint8_t *address, const uint8_t *mask, const std::string &locationID, const std::string &postalCode,
+                      double latitude, double longitude, double radius) {
+        GeoSnapshotIPv6Range range;
+        memset(&range, 0, sizeof(range));
+        uint32_t addressKey[4], maskKey[4];
+        ipRangeKeyFromBytes(address, addressKey);
+        ipRangeKeyFromBytes(mask, maskKey);
+        for(size_t i = 0; i < 4; ++i) {
+            range.start_ip[i] = addressKey[i] & maskKey[i];
+            range.end_ip[i] = addressKey[i] | ~maskKey[i];
+            range.prefixLength += __builtin_popcount(maskKey[i]);
+        }
+        range.location = addString(locationID);
+        range.postalCode = addString(postalCode);
+        range.latitude = latitude;
+        range.longitude = longitude;
+        range.radius = radius;
+        ipv6_.push_back(range);
+    }
+
+    // Builds the snapshot image.  Ranges whose location was not added, and
+    // ranges that overlap a range starting before them, are left out and
+    // counted in 'dropped'.
+    void build(std::vector<char> &image, size_t &dropped) const {
+        dropped = 0;
+        std::vector<GeoSnapshotIPv4Range> ipv4;
+        std::vector<GeoSnapshotIPv6Range> ipv6;
+        resolve<1>(ipv4_, ipv4, dropped);
+        resolve<4>(ipv6_, ipv6, dropped);
+
+        GeoSnapshotHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, GEO_SNAPSHOT_MAGIC, sizeof(header.magic));
+        header.version = GEO_SNAPSHOT_VERSION;
+        header.byteOrder = GEO_SNAPSHOT_BYTE_ORDER;
+
+        uint64_t offset = align(sizeof(header));
+        header.locationOffset = offset;
+        header.locationCount = locations_.size();
+        offset = align(offset + locations_.size() * sizeof(GeoSnapshotLocation));
+        header.ipv4Offset = offset;
+        header.ipv4Count = ipv4.size();
+        offset = align(offset + ipv4.size() * sizeof(GeoSnapshotIPv4Range));
+        header.ipv6Offset = offset;
+        header.ipv6Count = ipv6.size();
+        offset = align(offset + ipv6.size() * sizeof(GeoSnapshotIPv6Range));
+        header.stringOffset = offset;
+        header.stringSize = strings_.size();
+        header.fileSize = offset + strings_.size();
+
+        image.assign(header.fileSize, 0);
+        memcpy(&image[0], &header, sizeof(header));
+        if(!locations_.empty()) memcpy(&image[header.locationOffset], &locations_[0], locations_.size() * sizeof(GeoSnapshotLocation));
+        if(!ipv4.empty()) memcpy(&image[header.ipv4Offset], &ipv4[0], ipv4.size() * sizeof(GeoSnapshotIPv4Range));
+        if(!ipv6.empty()) memcpy(&image[header.ipv6Offset], &ipv6[0], ipv6.size() * sizeof(GeoSnapshotIPv6Range));
+        memcpy(&image[header.stringOffset], &strings_[0], strings_.size());
+    }
+
+    // Writes a snapshot image to a file.  The image is written to a
+    // temporary file in the same directory first and then renamed, so
+    // other processes never see a partial snapshot.  Returns an empty
+    // string on success, or an error message.
+    static std::string write(const std::string &filename, const std::vector<char> &image) {
+        char suffix[32];
+        snprintf(suffix, sizeof(suffix), ".%d.tmp", static_cast<int>(getpid()));
+        const std::string temporary = filename + suffix;
+
+        int fd = open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if(fd < 0) return "cannot create " + temporary + ", " + strerror(errno);
+
+        size_t written = 0;
+        while(written < image.size()) {
+            ssize_t rc = ::write(fd, &image[written], image.size() - written);
+            if(rc < 0 && errno == EINTR) continue;
+            if(rc < 0) {
+                std::string error = "cannot write " + temporary + ", " + strerror(errno);
+                close(fd);
+                unlink(temporary.c_str());
+                return error;
+            }
+            written += rc;
+        }
+
+        if(fsync(fd) != 0 || close(fd) != 0) {
+            std::string error = "cannot write " + temporary + ", " + strerror(errno);
+            unlink(temporary.c_str());
+            return error;
+        }
+
+        if(rename(temporary.c_str(), filename.c_str()) != 0) {
+            std::string error = "cannot rename " + temporary + " to " + filename + ", " + strerror(errno);
+            unlink(temporary.c_str());
+            return error;
+        }
+        return std::string();
+    }
+
+private:
+    static uint64_t align(uint64_t offset) {
+        return (offset + 7) & ~static_cast<uint64_t>(7);
+    }
+
+    template<size_t WORDS>
+    struct rangeLess {
+        template<typename Range>
+        bool operator()(const Range &a, const Range &b) const {
+            return ipRangeKeyLess<WORDS>(a.start_ip, b.start_ip);
+        }
+    };
+
+    // Sorts the ranges and replaces their location IDs by location indexes.
+    template<size_t WORDS, typename Range>
+    void resolve(const std::vector<Range> &ranges, std::vector<Range> &resolved, size_t &dropped) const {
+        resolved.clear();
+        resolved.reserve(ranges.size());
+        for(size_t i = 0; i < ranges.size(); ++i) {
+            std::tr1::unordered_map<uint32_t, uint32_t>::const_iterator l = locationIndex_.find(ranges[i].location);
+            if(l == locationIndex_.end()) { ++dropped; continue; }
+            resolved.push_back(ranges[i]);
+            resolved.back().location = l->second;
+        }
+
+        std::stable_sort(resolved.begin(), resolved.end(), rangeLess<WORDS>());
+
+        size_t kept = 0;
+        for(size_t i = 0; i < resolved.size(); ++i) {
+            if(kept > 0 && !ipRangeKeyLess<WORDS>(resolved[kept - 1].end_ip, resolved[i].start_ip)) { ++dropped; continue; }
+            resolved[kept++] = resolved[i];
+        }
+        resolved.resize(kept);
+    }
+
+    uint32_t addString(const std::string &str) {
+        if(str.empty()) return 0;
+        std::tr1::unordered_map<std::string, uint32_t>::const_iterator s = stringIndex_.find(str);
+        if(s != stringIndex_.end()) return s->second;
+
+        uint32_t offset = static_cast<uint32_t>(strings_.size());
+        strings_.insert(strings_.end(), str.begin(), str.end());
+        strings_.push_back('\0');
+        stringIndex_[str] = offset;
+        return offset;
+    }
+
+    // The string section, and the offset of each string in it.
+    std::vector<char> strings_;
+    std::tr1::unordered_map<std::string, uint32_t> stringIndex_;
+
+    // The locations, and the index of each location by the offset of its ID.
+    std::vector<GeoSnapshotLocation> locations_;
+    std::tr1::unordered_map<uint32_t, uint32_t> locationIndex_;
+
+    // The ranges, with the offset of their location ID in 'location'.
+    std::vector<GeoSnapshotIPv4Range> ipv4_;
+    std::vector<GeoSnapshotIPv6Range> ipv6_;
+};
+
+
+// This class searches a snapshot image, which is either mapped read-only
+// from a file or built in memory by a GeoSnapshotWriter.  The find and
+// accessor functions are const and may be called from any number of
+// threads at once, but map(), adopt() and clear() must not be called while
+// any other thread is using the snapshot.
+class GeoSnapshot {
+public:
+    GeoSnapshot(): mapBase_(NULL), mapSize_(0) {
+        reset();
+    }
+
+    ~GeoSnapshot() {
+        clear();
+    }
+
+    // Maps a snapshot file.  Returns an empty string on success, or an error
+    // message, in which case the previous snapshot is kept.
+    std::string map(const std::string &filename) {
+        int fd = open(filename.c_str(), O_RDONLY);
+        if(fd < 0) return "cannot open " + filename + ", " + strerror(errno);
+
+        struct stat status;
+        if(fstat(fd, &status) != 0) {
+            std::string error = "cannot stat " + filename + ", " + strerror(errno);
+            close(fd);
+            return error;
+        }
+        if(static_cast<size_t>(status.st_size) < sizeof(GeoSnapshotHeader)) {
+            close(fd);
+            return filename + " is not a geography snapshot";
+        }
+
+        void *base = mmap(NULL, status.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        int mapErrno = errno;
+        close(fd);
+        if(base == MAP_FAILED) return "cannot map " + filename + ", " + strerror(mapErrno);
+
+        std::string error = check(static_cast<const char *>(base), status.st_size);
+        if(!error.empty()) {
+            munmap(base, status.st_size);
+            return filename + " " + error;
+        }
+
+        clear();
+        mapBase_ = base;
+        mapSize_ = status.st_size;
+        attach(static_cast<const char *>(base));
+        return std::string();
+    }
+
+    // Takes over an image built by GeoSnapshotWriter::build(), leaving
+    // 'image' empty.
+    void adopt(std::vector<char> &image) {
+        clear();
+        image_.swap(image);
+        if(!image_.empty()) attach(&image_[0]);
+    }
+
+    // Drops the snapshot, unmapping it if it was mapped from a file.
+    void clear() {
+        if(mapBase_) munmap(mapBase_, mapSize_);
+        mapBase_ = NULL;
+        mapSize_ = 0;
+        std::vector<char>().swap(image_);
+        reset();
+    }
+
+    // Returns true if the snapshot was mapped from a file.
+    bool mapped() const { return (mapBase_ != NULL); }
+
+    size_t locationCount() const { return locationCount_; }
+    size_t ipv4RangeCount() const { return ipv4Count_; }
+    size_t ipv6RangeCount() const { return ipv6Count_; }
+
+    // Returns the range containing an IPv4 address in host byte order, or NULL.
+    const GeoSnapshotIPv4Range *findIPv4(uint32_t address) const {
+        return findIPRange<1>(ipv4_, ipv4Count_, &address);
+    }
+
+    // Returns the range containing an IPv6 address given as sixteen bytes
+    // in network byte order, or NULL.
+    const GeoSnapshotIPv6Range *findIPv6(const uint8_t *bytes) const {
+        uint32_t key[4];
+        ipRangeKeyFromBytes(bytes, key);
+        return findIPRange<4>(ipv6_, ipv6Count_, key);
+    }
+
+    // Returns a string field of the location of a range.
+    template<typename Range>
+    const char *locationField(const Range &range, GeoLocationField field) const {
+        if(range.location >= locationCount_) return "";
+        return string(locations_[range.location].field[field]);
+    }
+
+    // Returns the string at an offset in the string section.
+    const char *string(uint32_t offset) const {
+        return (offset < stringSize_) ? strings_ + offset : "";
+    }
+
+    // The sections, for copying the snapshot into a GeoSnapshotWriter.
+    const GeoSnapshotLocation *locations() const { return locations_; }
+    const GeoSnapshotIPv4Range *ipv4Ranges() const { return ipv4_; }
+    const GeoSnapshotIPv6Range *ipv6Ranges() const { return ipv6_; }
+
+private:
+    GeoSnapshot(const GeoSnapshot &);
+    GeoSnapshot &operator=(const GeoSnapshot &);
+
+    void reset() {
+        locations_ = NULL;
+        locationCount_ = 0;
+        ipv4_ = NULL;
+        ipv4Count_ = 0;
+        ipv6_ = NULL;
+        ipv6Count_ = 0;
+        strings_ = NULL;
+        stringSize_ = 0;
+    }
+
+    // Verifies that an image has a valid header and that its sections are
+    // within the image.  Returns an empty string if so, or what is wrong.
+    static std::string check(const char *base, size_t size) {
+        const GeoSnapshotHeader *header = reinterpret_cast<const GeoSnapshotHeader *>(base);
+        if(memcmp(header->magic, GEO_SNAPSHOT_MAGIC, sizeof(header->magic)) != 0) return "is not a geography snapshot";
+        if(header->byteOrder != GEO_SNAPSHOT_BYTE_ORDER) return "was written on a host with a different byte order";
+        if(header->version != GEO_SNAPSHOT_VERSION) return "has an unsupported snapshot version";
+        if(header->fileSize != size) return "is truncated";
+        if(!section(header->locationOffset, header->locationCount, sizeof(GeoSnapshotLocation), size) ||
+           !section(header->ipv4Offset, header->ipv4Count, sizeof(GeoSnapshotIPv4Range), size) ||
+           !section(header->ipv6Offset, header->ipv6Count, sizeof(GeoSnapshotIPv6Range), size) ||
+           !section(header->stringOffset, header->stringSize, 1, size) ||
+           header->stringSize == 0 || base[header->stringOffset + header->stringSize - 1] != '\0') {
+            return "is corrupt";
+        }
+        return std::string();
+    }
+
+    static bool section(uint64_t offset, uint64_t count, uint64_t recordSize, uint64_t size) {
+        return (offset % 8 == 0 && offset <= size && count <= (size - offset) / recordSize);
+    }
+
+    void attach(const char *base) {
+        const GeoSnapshotHeader *header = reinterpret_cast<const GeoSnapshotHeader *>(base);
+        locations_ = reinterpret_cast<const GeoSnapshotLocation *>(base + header->locationOffset);
+        locationCount_ = header->locationCount;
+        ipv4_ = reinterpret_cast<const GeoSnapshotIPv4Range *>(base + header->ipv4Offset);
+        ipv4Count_ = header->ipv4Count;
+        ipv6_ = reinterpret_cast<const GeoSnapshotIPv6Range *>(base + header->ipv6Offset);
+        ipv6Count_ = header->ipv6Count;
+        strings_ = base + header->stringOffset;
+        stringSize_ = header->stringSize;
+    }
+
+    // The mapped file, if there is one, otherwise the image is in image_.
+    void *mapBase_;
+    size_t mapSize_;
+    std::vector<char> image_;
+
+    const GeoSnapshotLocation *locations_;
+    size_t locationCount_;
+    const GeoSnapshotIPv4Range *ipv4_;
+    size_t ipv4Count_;
+    const GeoSnapshotIPv6Range *ipv6_;
+    size_t ipv6Count_;
+    const char *strings_;
+    size_t stringSize_;
+};
+
+
+inline void GeoSnapshotWriter::assign(const GeoSnapshot &snapshot) {
+    clear();
+
+    for(size_t i = 0; i < snapshot.locationCount(); ++i) {
+        std::string fields[GEO_LOCATION_FIELDS];
+        for(size_t f = 0; f < GEO_LOCATION_FIELDS; ++f) fields[f] = snapshot.string(snapshot.locations()[i].field[f]);
+        addLocation(fields);
+    }
+
+    // the ranges go back to naming their location by its ID, as if added again
+    ipv4_.reserve(snapshot.ipv4RangeCount());
+    for(size_t i = 0; i < snapshot.ipv4RangeCount(); ++i) {
+        GeoSnapshotIPv4Range range = snapshot.ipv4Ranges()[i];
+        range.location = addString(snapshot.locationField(range, GEO_LOCATION_ID));
+        range.postalCode = addString(snapshot.string(range.postalCode));
+        ipv4_.push_back(range);
+    }
+    ipv6_.reserve(snapshot.ipv6RangeCount());
+    for(size_t i = 0; i < snapshot.ipv6RangeCount(); ++i) {
+        GeoSnapshotIPv6Range range = snapshot.ipv6Ranges()[i];
+        range.location = addString(snapshot.locationField(range, GEO_LOCATION_ID));
+        range.postalCode = addString(snapshot.string(range.postalCode));
+        ipv6_.push_back(range);
+    }
+}
+
+} } } }
+
+#endif
@@ -0,0 +1,185 @@
+/*********************************************************************
+ * Copyright (C) 2026 International Business Machines Corporation
+ * All Rights Reserved
+ ********************************************************************/
+
+#ifndef IP_PREFIX_TRIE_H_
+#define IP_PREFIX_TRIE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+namespace com { namespace ibm { namespace streamsx { namespace network {
+
+// This class is a multibit trie for storing a set of IP prefixes (CIDRs)
+// and testing whether an address is covered by any of them.  Keys are
+// KEY_BITS long and passed as byte arrays in network byte order.
+//
+// The root level is indexed by the first 16 bits of the key, and every
+// level below it by one more byte, so an IPv4 lookup touches at most
+// three table entries no matter how many prefixes are loaded.  Prefixes
+// that do not end on a level boundary are expanded into the range of
+// entries they cover within their level (at most 2^15 entries in the
+// root, 2^7 below it), so loading a /8 costs 256 stores instead of 16M
+// hash inserts.
+//
+// Since the only question asked is "is this address covered", an entry
+// that is fully covered by a prefix is simply marked as a hit and any
+// subtree below it is abandoned.  Abandoned nodes are not reused until
+// the next clear(), which keeps inserts trivial; filter lists are
+// rebuilt from scratch on each reload anyway.
+//
+// All nodes live in one flat vector, so clear() keeps its capacity and
+// the next reload of a similarly sized list does not allocate at all.
+template<size_t KEY_BITS>
+class IPPrefixTrie {
+public:
+    static_assert(KEY_BITS >= 24 && KEY_BITS % 8 == 0, "IPPrefixTrie::KEY_BITS must be a whole number of bytes, at least 24 bits.");
+
+    static const size_t KEY_BYTES = KEY_BITS / 8;
+    static const unsigned ROOT_STRIDE = 16;
+    static const unsigned NODE_STRIDE = 8;
+    static const size_t ROOT_SIZE = 1 << ROOT_STRIDE;
+    static const size_t NODE_SIZE = 1 << NODE_STRIDE;
+
+protected:
+    // Table entries are either MISS, HIT, or the index of the first entry
+    // of a child node.  Child nodes are always allocated after the root,
+    // so a child index can never collide with MISS or HIT.
+    enum { MISS = 0, HIT = 1 };
+
+public:
+    IPPrefixTrie(): table_(ROOT_SIZE, MISS), prefixCount_(0) {}
+
+    // Removes all prefixes, keeping the allocated memory for the next load.
+    void clear() {
+        table_.assign(ROOT_SIZE, MISS);
+        prefixCount_ = 0;
+    }
+
+    // Adds a prefix of 'prefixLen' bits taken from 'key'.  Bits of the
+    // key beyond the prefix length are ignored.
+    // Returns false if the prefix length is out of range.
+    bool insert(const uint8_t *key, unsigned prefixLen) {
+        if(prefixLen > KEY_BITS) return false;
+
+        ++prefixCount_;
+
+        size_t rootIndex = (static_cast<size_t>(key[0]) << 8) | key[1];
+        if(prefixLen <= ROOT_STRIDE) {
+            fill(0, rootIndex, ROOT_STRIDE - prefixLen);
+            return true;
+        }
+
+        size_t slot = rootIndex;
+        unsigned consumed = ROOT_STRIDE;
+        for(size_t byte = 2; byte < KEY_BYTES; ++byte) {
+            uint32_t entry = table_[slot];
+
+            // Already covered by a shorter prefix, nothing to add.
+            if(entry == HIT) return true;
+
+            if(entry == MISS) {
+                entry = allocateNode();
+                table_[slot] = entry;
+            }
+
+            unsigned remaining = prefixLen - consumed;
+            if(remaining <= NODE_STRIDE) {
+                fill(entry, key[byte], NODE_STRIDE - remaining);
+                return true;
+            }
+
+            slot = entry + key[byte];
+            consumed += NODE_STRIDE;
+        }
+
+        // Not reached, the prefix length check above guarantees the
+        // prefix ends within the last level.
+        return true;
+    }
+
+    // Returns true if 'key' is covered by at least one prefix in the set.
+    bool contains(const uint8_t *key) const {
+        const uint32_t *table = &table_[0];
+        uint32_t entry = table[(static_cast<size_t>(key[0]) << 8) | key[1]];
+        for(size_t byte = 2; entry > HIT; ++byte) {
+            entry = table[entry + key[byte]];
+        }
+        return (entry == HIT);
+    }
+
+    // Returns true if no prefixes have been added since the last clear().
+    bool empty() const {
+        return (prefixCount_ == 0);
+    }
+
+    // Returns the number of prefixes added since the last clear(),
+    // including ones that were already covered by other prefixes.
+    size_t size() const {
+        return prefixCount_;
+    }
+
+    // Returns the number of bytes currently used by the trie tables.
+    size_t memoryUsage() const {
+        return table_.capacity() * sizeof(uint32_t);
+    }
+
+protected:
+    // Marks the aligned block of 2^hostBits entries containing 'index' in
+    // the node starting at 'node' as covered.
+    void fill(size_t node, size_t index, unsigned hostBits) {
+        size_t first = node + ((index >> hostBits) << hostBits);
+        size_t last = first + (static_cast<size_t>(1) << hostBits);
+        for(size_t i = first; i < last; ++i) {
+            table_[i] = HIT;
+        }
+    }
+
+    // Appends an empty node to the table and returns its starting index.
+    uint32_t allocateNode() {
+        size_t node = table_.size();
+        table_.resize(node + NODE_SIZE, MISS);
+        return static_cast<uint32_t>(node);
+    }
+
+    std::vector<uint32_t> table_;
+    size_t prefixCount_;
+};
+
+
+// IPv4 prefix set, with convenience functions for addresses held as
+// 32 bit integers in host byte order, as the toolkit's IPv4 functions do.
+class IPv4PrefixTrie : public IPPrefixTrie<32> {
+public:
+    bool insert(uint32_t address, unsigned prefixLen) {
+        uint8_t key[4] = { static_cast<uint8_t>(address >> 24), static_cast<uint8_t>(address >> 16),
+                           static_cast<uint8_t>(address >> 8), static_cast<uint8_t>(address) };
+        return IPPrefixTrie<32>::insert(key, prefixLen);
+    }
+
+    bool contains(uint32_t address) const {
+        const uint32_t *table = &table_[0];
+        uint32_t entry = table[address >> 16];
+        if(entry > HIT) {
+            entry = table[entry + ((address >> 8) & 0xff)];
+            if(entry > HIT) {
+                entry = table[entry + (address & 0xff)];
+            }
+        }
+        return (entry == HIT);
+    }
+
+    using IPPrefixTrie<32>::insert;
+    using IPPrefixTrie<32>::contains;
+};
+
+
+// IPv6 prefix set.  Addresses are the sixteen byte network order
+// representation used by the toolkit's IPv6 functions.
+typedef IPPrefixTrie<128> IPv6PrefixTrie;
+
+} } } }
+
+#endif
@@ -0,0 +1,220 @@
+/*********************************************************************
+ * Copyright (C) 2026 International Business Machines Corporation
+ * All Rights Reserved
+ ********************************************************************/
+
+#ifndef IP_RANGE_TABLE_H_
+#define IP_RANGE_TABLE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <arpa/inet.h>
+#include <algorithm>
+#include <vector>
+
+namespace com { namespace ibm { namespace streamsx { namespace network {
+
+// These functions search the IP range tables of the enrichment operators.
+// A table is a std::vector of records sorted by their start address, where
+// each record has 'uint32 start_ip[4]' and 'uint32 end_ip[4]' members
+// holding the first and last address of the range as 32 bit words in host
+// byte order, most significant word first.  IPv4 ranges use word 0 only.
+//
+// Ranges are expected not to overlap, as in the MaxMind GeoIP files.  A
+// key matches the last range that starts at or below it, if the key is
+// also at or below the end of that range.
+
+// Compares the first WORDS words of two addresses.
+template<size_t WORDS>
+inline bool ipRangeKeyLess(const uint32_t *a, const uint32_t *b) {
+    for(size_t i = 0; i < WORDS; ++i) {
+        if(a[i] != b[i]) return (a[i] < b[i]);
+    }
+    return false;
+}
+
+// Converts a sixteen byte network order IPv6 address to a key.
+inline void ipRangeKeyFromBytes(const uint8_t *bytes, uint32_t (&key)[4]) {
+    for(size_t i = 0; i < 4; ++i) {
+        key[i] = (static_cast<uint32_t>(bytes[4*i]) << 24) | (static_cast<uint32_t>(bytes[4*i+1]) << 16) |
+                 (static_cast<uint32_t>(bytes[4*i+2]) << 8) | static_cast<uint32_t>(bytes[4*i+3]);
+    }
+}
+
+// Converts an IPv4 or IPv6 address string to a key.  Returns 4 or 6 for
+// the address family, or 0 if the string is not a valid address.  Only
+// one conversion is attempted, chosen by whether the string contains a ':'.
+inline int ipRangeKeyFromString(const char *str, uint32_t (&key)[4]) {
+    if(strchr(str, ':') == NULL) {
+        in_addr addr;
+        if(inet_pton(AF_INET, str, &addr) != 1) return 0;
+        key[0] = ntohl(addr.s_addr);
+        key[1] = key[2] = key[3] = 0;
+        return 4;
+    }
+
+    uint8_t bytes[16];
+    if(inet_pton(AF_INET6, str, bytes) != 1) return 0;
+    ipRangeKeyFromBytes(bytes, key);
+    return 6;
+}
+
+// Returns the record whose range contains 'key', or NULL.  The table is
+// given as an array of 'size' records, e.g. one mapped from a file.
+template<size_t WORDS, typename Record>
+inline const Record *findIPRange(const Record *table, size_t size, const uint32_t *key) {
+    // binary search for the first range starting above the key
+    size_t first = 0;
+    size_t count = size;
+    while(count > 0) {
+        size_t half = count / 2;
+        if(ipRangeKeyLess<WORDS>(key, table[first + half].start_ip)) {
+            count = half;
+        } else {
+            first += half + 1;
+            count -= half + 1;
+        }
+    }
+
+    if(first == 0) return NULL;
+    const Record &record = table[first - 1];
+    return ipRangeKeyLess<WORDS>(record.end_ip, key) ? NULL : &record;
+}
+
+// Returns the record whose range contains 'key', or NULL.
+template<size_t WORDS, typename Record>
+inline const Record *findIPRange(const std::vector<Record> &table, const uint32_t *key) {
+    return table.empty() ? NULL : findIPRange<WORDS>(&table[0], table.size(), key);
+}
+
+
+// This class looks up a batch of addresses, such as the elements of a list
+// attribute, in one pass over the range tables.  The addresses are sorted
+// and the tables are walked from left to right, galloping from one match to
+// the next, so the cost grows with the size of the batch and the distance
+// between neighbouring keys rather than with a full binary search per key.
+//
+// Addresses are add()ed in order, then find() stores the matching record
+// for the n-th address added (or NULL if there is none) in results[n].
+// A batch can be clear()ed and reused without reallocating.
+class IPRangeBatch {
+public:
+    IPRangeBatch(): count_(0) {}
+
+    void clear() {
+        queries4_.clear();
+        queries6_.clear();
+        count_ = 0;
+    }
+
+    // Makes room for 'count' addresses, so that batches up to that size
+    // are added without reallocating.
+    void reserve(size_t count) {
+        queries4_.reserve(count);
+        queries6_.reserve(count);
+    }
+
+    // Returns the number of addresses added since the last clear().
+    size_t size() const {
+        return count_;
+    }
+
+    // Adds an IPv4 address in host byte order.
+    void addIPv4(uint32_t hostAddr) {
+        query q = { { hostAddr, 0, 0, 0 }, count_++ };
+        queries4_.push_back(q);
+    }
+
+    // Adds an IPv6 address as sixteen bytes in network byte order.
+    void addIPv6(const uint8_t *bytes) {
+        query q;
+        ipRangeKeyFromBytes(bytes, q.key);
+        q.index = count_++;
+        queries6_.push_back(q);
+    }
+
+    // Adds an IPv4 or IPv6 address string.  A string that is not a valid
+    // address takes a slot in the results but never matches.
+    void addString(const char *str) {
+        query q;
+        int family = ipRangeKeyFromString(str, q.key);
+        q.index = count_++;
+        if(family == 4) queries4_.push_back(q);
+        else if(family == 6) queries6_.push_back(q);
+    }
+
+    // Adds an address that never matches, e.g. an attribute that is not
+    // filled in.
+    void addNone() {
+        ++count_;
+    }
+
+    template<typename Record>
+    void find(const std::vector<Record> &table4, const std::vector<Record> &table6, std::vector<const Record *> &results) {
+        results.assign(count_, NULL);
+        walk<1>(table4, queries4_, results);
+        walk<4>(table6, queries6_, results);
+    }
+
+private:
+    struct query {
+        uint32_t key[4];
+        size_t index;
+    };
+
+    template<size_t WORDS>
+    struct queryLess {
+        bool operator()(const query &a, const query &b) const {
+            return ipRangeKeyLess<WORDS>(a.key, b.key);
+        }
+    };
+
+    template<size_t WORDS, typename Record>
+    static void walk(const std::vector<Record> &table, std::vector<query> &queries, std::vector<const Record *> &results) {
+        if(queries.empty() || table.empty()) return;
+
+        std::sort(queries.begin(), queries.end(), queryLess<WORDS>());
+
+        // 'next' is the first range starting above the previous key, which
+        // only ever moves forward since the keys are sorted
+        size_t next = 0;
+        const size_t size = table.size();
+        for(size_t q = 0; q < queries.size(); ++q) {
+            const uint32_t *key = queries[q].key;
+
+            // gallop forward until a range starting above the key is passed,
+            // then binary search the last step
+            size_t low = next;
+            size_t step = 1;
+            size_t high = next;
+            while(high < size && !ipRangeKeyLess<WORDS>(key, table[high].start_ip)) {
+                low = high + 1;
+                high += step;
+                step *= 2;
+            }
+            if(high > size) high = size;
+            while(low < high) {
+                size_t middle = low + (high - low) / 2;
+                if(ipRangeKeyLess<WORDS>(key, table[middle].start_ip)) {
+                    high = middle;
+                } else {
+                    low = middle + 1;
+                }
+            }
+            next = low;
+
+            if(next > 0 && !ipRangeKeyLess<WORDS>(table[next - 1].end_ip, key)) {
+                results[queries[q].index] = &table[next - 1];
+            }
+        }
+    }
+
+    std::vector<query> queries4_;
+    std::vector<query> queries6_;
+    size_t count_;
+};
+
+} } } }
+
+#endif
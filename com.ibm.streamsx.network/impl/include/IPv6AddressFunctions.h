@@ -21,8 +21,30 @@
     && (a[2] == b[2]) \
     && (a[3] == b[3]))
 
+struct network_cidr6 {
+    uint8_t ip[16];
+    uint32_t prefix;
+};
+
 namespace com { namespace ibm { namespace streamsx { namespace network { namespace ipv6 {
 
+    /*
+     * Internal use only. Splits an IPv6 networkCIDR string into IP and prefix components
+     */
+    inline SPL::boolean parseNetworkCIDR_(SPL::rstring const & networkCIDR, network_cidr6 &resultCIDR)
+    {
+        SPL::list<SPL::rstring> tokens = SPL::Functions::String::tokenize(networkCIDR, "/", false);
+        if(tokens.size() != 2) return false;
+
+        if (inet_pton(AF_INET6, tokens[0].c_str(), resultCIDR.ip) != 1) return false;
+
+        SPL::int64 prefix = SPL::Functions::Utility::strtoll(tokens[1], 10);
+        if(prefix > 128 || prefix < 0) return false;
+        resultCIDR.prefix = prefix;
+
+        return true;
+    }
+
       // This function converts a sixteen-byte binary representation of an
       // IPv6 address into a string representation.
 
@@ -0,0 +1,419 @@
+/*********************************************************************
+ * Copyright (C) 2026 International Business Machines Corporation
+ * All Rights Reserved
+ ********************************************************************/
+
+#ifndef PACKET_FILE_DECOMPRESSOR_H_
+#define PACKET_FILE_DECOMPRESSOR_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dlfcn.h>
+#include <zlib.h>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace com { namespace ibm { namespace streamsx { namespace network {
+
+// This class decompresses a gzip, zstd or lz4 compressed capture file on a
+// thread of its own, so that the reader can parse packets from one buffer
+// while the next buffer is being decompressed:
+//
+//     PacketFileDecompressor decompressor;
+//     std::string error = decompressor.open(fd, PacketFileDecompressor::method(magic, length));
+//     PacketFileDecompressor::Buffer *buffer;
+//     while ((buffer = decompressor.take())) {
+//       ... buffer->data, buffer->length ...
+//       decompressor.release(buffer);
+//     }
+//     if (!decompressor.error().empty()) ...
+//
+// There are two buffers.  The decompression thread fills one while the
+// reader holds the other, and waits for the reader to release it before
+// filling it again.  Each buffer has room for 'HEADROOM' bytes before its
+// data, where the reader may copy the unread end of the previous buffer,
+// so that a packet split between buffers becomes contiguous without copying
+// the whole buffer.
+//
+// The compression libraries are loaded when the first file compressed with
+// them is opened, so they need only be installed on machines that read
+// compressed files.  Files may contain several concatenated gzip members,
+// zstd frames or lz4 frames.
+class PacketFileDecompressor {
+public:
+    enum Method { noMethod, gzipMethod, zstdMethod, lz4Method };
+
+    enum {
+        CAPACITY = 4 * 1024 * 1024,               // size of decompressed data in each buffer
+        HEADROOM = 512 * 1024                     // room before the data for the end of the previous buffer
+    };
+
+    struct Buffer {
+        uint8_t *data;                            // decompressed data, preceded by 'HEADROOM' writable bytes
+        size_t length;                            // length of decompressed data
+        bool full;                                // filled by the decompression thread, not yet taken by the reader
+        bool last;                                // last buffer of the file, which may be empty
+        std::vector<uint8_t> storage;
+    };
+
+    PacketFileDecompressor(): fd_(-1), method_(noMethod), next_(0), finished_(false), stopping_(false) {
+        for(int i = 0; i < 2; i++) {
+            buffers_[i].data = NULL;
+            free_[i] = true;
+        }
+    }
+
+    ~PacketFileDecompressor() {
+        close();
+    }
+
+    // Returns the compression method of a file that begins with 'magic', or
+    // 'noMethod' if the file is not compressed with a recognized method.
+    static Method method(const uint8_t *magic, size_t length) {
+        if(length >= 2 && magic[0] == 0x1f && magic[1] == 0x8b) return gzipMethod;
+        if(length >= 4 && magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f && magic[3] == 0xfd) return zstdMethod;
+        if(length >= 4 && magic[0] == 0x04 && magic[1] == 0x22 && magic[2] == 0x4d && magic[3] == 0x18) return lz4Method;
+        return noMethod;
+    }
+
+    static const char *name(Method method) {
+        switch(method) {
+        case gzipMethod: return "gzip";
+        case zstdMethod: return "zstd";
+        case lz4Method: return "lz4";
+        default: return "none";
+        }
+    }
+
+    // Starts decompressing the file open at 'fd' from its beginning with
+    // 'method'.  The caller continues to own 'fd', and must not close it
+    // before calling close().  Returns an empty string on success, or an
+    // error message.
+    std::string open(int fd, Method method) {
+        close();
+
+        const Library &library = load(method);
+        if(!library.error.empty()) return library.error;
+
+        fd_ = fd;
+        method_ = method;
+        stopping_ = false;
+        finished_ = false;
+        next_ = 0;
+        error_.clear();
+        for(int i = 0; i < 2; i++) {
+            // the buffers are allocated for the first compressed file
+            if(buffers_[i].storage.empty()) {
+                buffers_[i].storage.resize(HEADROOM + CAPACITY);
+                buffers_[i].data = &buffers_[i].storage[HEADROOM];
+            }
+            buffers_[i].length = 0;
+            buffers_[i].full = false;
+            buffers_[i].last = false;
+            free_[i] = true;
+        }
+        posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+        thread_ = std::thread(&PacketFileDecompressor::decompress, this);
+        return std::string();
+    }
+
+    // Stops the decompression thread.
+    void close() {
+        if(thread_.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stopping_ = true;
+            }
+            changed_.notify_all();
+            thread_.join();
+        }
+        fd_ = -1;
+        method_ = noMethod;
+    }
+
+    Method method() const {
+        return method_;
+    }
+
+    // Waits for the next buffer of decompressed data, which the reader owns
+    // until it calls release().  Returns NULL at the end of the file, or if
+    // the file cannot be decompressed, in which case error() describes why.
+    Buffer *take() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while(true) {
+            // the decompression thread fills the buffers alternately
+            Buffer &buffer = buffers_[next_];
+            if(buffer.full) {
+                buffer.full = false;
+                next_ = 1 - next_;
+                if(buffer.last && buffer.length == 0) return NULL;
+                return &buffer;
+            }
+            if(finished_) return NULL;
+            changed_.wait(lock);
+        }
+    }
+
+    // Returns a buffer to the decompression thread, to be filled again.
+    void release(Buffer *buffer) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            buffer->length = 0;
+            free_[buffer == &buffers_[0] ? 0 : 1] = true;
+        }
+        changed_.notify_all();
+    }
+
+    // Returns a description of the error that stopped decompression, or an
+    // empty string.  Valid after take() has returned NULL.
+    const std::string &error() const {
+        return error_;
+    }
+
+private:
+    enum { INPUT = 1024 * 1024 };                 // size of reads from the compressed file
+
+    // the parts of the zstd and lz4 interfaces used here, which are stable
+    // across versions of those libraries
+    struct ZSTDInput { const void *source; size_t size; size_t position; };
+    struct ZSTDOutput { void *destination; size_t size; size_t position; };
+
+    // the functions used from a compression library
+    struct Library {
+        std::string error;                        // why the library could not be loaded, or empty
+        int (*inflateInit2_)(z_streamp, int, const char *, int);
+        int (*inflate)(z_streamp, int);
+        int (*inflateReset)(z_streamp);
+        int (*inflateEnd)(z_streamp);
+        void *(*ZSTD_createDStream)(void);
+        size_t (*ZSTD_freeDStream)(void *);
+        size_t (*ZSTD_decompressStream)(void *, ZSTDOutput *, ZSTDInput *);
+        unsigned (*ZSTD_isError)(size_t);
+        const char *(*ZSTD_getErrorName)(size_t);
+        size_t (*LZ4F_createDecompressionContext)(void **, unsigned);
+        size_t (*LZ4F_freeDecompressionContext)(void *);
+        size_t (*LZ4F_decompress)(void *, void *, size_t *, const void *, size_t *, const void *);
+        unsigned (*LZ4F_isError)(size_t);
+        const char *(*LZ4F_getErrorName)(size_t);
+    };
+
+    PacketFileDecompressor(const PacketFileDecompressor &);
+    PacketFileDecompressor &operator=(const PacketFileDecompressor &);
+
+    // loads the library for 'method' the first time it is needed, and
+    // returns its functions thereafter
+    static const Library &load(Method method) {
+        static std::mutex mutex;
+        static bool loaded[4];
+        static Library libraries[4];              // function pointers are zero until loaded
+        std::lock_guard<std::mutex> lock(mutex);
+        Library &library = libraries[method];
+        if(loaded[method]) return library;
+        loaded[method] = true;
+
+        const char *filename = method == gzipMethod ? "libz.so.1" : method == zstdMethod ? "libzstd.so.1" : method == lz4Method ? "liblz4.so.1" : NULL;
+        if(!filename) {
+            library.error = "unrecognized compression method";
+            return library;
+        }
+        void *handle = dlopen(filename, RTLD_NOW);
+        if(!handle) {
+            library.error = std::string("cannot load ") + name(method) + " library, " + dlerror();
+            return library;
+        }
+        bool found = true;
+        switch(method) {
+        case gzipMethod:
+            found = symbol(handle, "inflateInit2_", library.inflateInit2_) && symbol(handle, "inflate", library.inflate) &&
+                    symbol(handle, "inflateReset", library.inflateReset) && symbol(handle, "inflateEnd", library.inflateEnd);
+            break;
+        case zstdMethod:
+            found = symbol(handle, "ZSTD_createDStream", library.ZSTD_createDStream) && symbol(handle, "ZSTD_freeDStream", library.ZSTD_freeDStream) &&
+                    symbol(handle, "ZSTD_decompressStream", library.ZSTD_decompressStream) && symbol(handle, "ZSTD_isError", library.ZSTD_isError) &&
+                    symbol(handle, "ZSTD_getErrorName", library.ZSTD_getErrorName);
+            break;
+        case lz4Method:
+            found = symbol(handle, "LZ4F_createDecompressionContext", library.LZ4F_createDecompressionContext) &&
+                    symbol(handle, "LZ4F_freeDecompressionContext", library.LZ4F_freeDecompressionContext) &&
+                    symbol(handle, "LZ4F_decompress", library.LZ4F_decompress) && symbol(handle, "LZ4F_isError", library.LZ4F_isError) &&
+                    symbol(handle, "LZ4F_getErrorName", library.LZ4F_getErrorName);
+            break;
+        default:
+            break;
+        }
+        if(!found) library.error = std::string("cannot find functions in ") + name(method) + " library, " + dlerror();
+        return library;
+    }
+
+    template<typename Function> static bool symbol(void *handle, const char *name, Function &function) {
+        function = reinterpret_cast<Function>(dlsym(handle, name));
+        return function != NULL;
+    }
+
+    // the decompression thread, which fills buffers until the end of the
+    // file, an error, or close()
+    void decompress() {
+        const Library &library = load(method_);
+        std::vector<uint8_t> input(INPUT);
+        const uint8_t *available = NULL;          // next compressed byte not yet decompressed
+        size_t remaining = 0;                     // number of compressed bytes not yet decompressed
+        bool inputEnded = false;
+        bool frameEnded = true;                   // at the end of a gzip member, zstd frame or lz4 frame
+        std::string error;
+
+        z_stream zstream;
+        memset(&zstream, 0, sizeof(zstream));
+        void *context = NULL;
+        bool initialized = false;
+        switch(method_) {
+        case gzipMethod: {
+            // 15 bits of window, plus 16 to expect a gzip header rather than a zlib header
+            const int status = library.inflateInit2_(&zstream, 15 + 16, ZLIB_VERSION, (int)sizeof(z_stream));
+            if(status != Z_OK) error = std::string("cannot initialize gzip decompression, ") + (zstream.msg ? zstream.msg : "");
+            else initialized = true;
+            break; }
+        case zstdMethod:
+            context = library.ZSTD_createDStream();
+            if(!context) error = "cannot initialize zstd decompression";
+            else initialized = true;
+            break;
+        case lz4Method: {
+            const size_t status = library.LZ4F_createDecompressionContext(&context, 100); // LZ4F_VERSION
+            if(library.LZ4F_isError(status)) error = std::string("cannot initialize lz4 decompression, ") + library.LZ4F_getErrorName(status);
+            else initialized = true;
+            break; }
+        default:
+            error = "unrecognized compression method";
+            break;
+        }
+
+        int index = 0;
+        bool last = !error.empty();
+        while(true) {
+
+            // wait for the reader to release the next buffer
+            Buffer &buffer = buffers_[index];
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                while(!free_[index] && !stopping_) changed_.wait(lock);
+                if(stopping_) break;
+                free_[index] = false;
+            }
+
+            // decompress into the buffer until it is full or the file ends
+            size_t filled = 0;
+            while(!last && filled < CAPACITY) {
+
+                if(remaining == 0 && !inputEnded) {
+                    const ssize_t count = ::read(fd_, &input[0], input.size());
+                    if(count < 0) {
+                        if(errno == EINTR) continue;
+                        error = std::string("cannot read compressed file, ") + strerror(errno);
+                        last = true;
+                        break;
+                    }
+                    if(count == 0) inputEnded = true;
+                    available = &input[0];
+                    remaining = count;
+                }
+                if(remaining == 0 && inputEnded) {
+                    if(!frameEnded) error = std::string("truncated ") + name(method_) + " compressed data";
+                    last = true;
+                    break;
+                }
+
+                size_t consumed = 0;
+                size_t produced = 0;
+                if(method_ == gzipMethod) {
+                    // a new member may begin after the end of the previous one
+                    if(frameEnded && zstream.total_out) library.inflateReset(&zstream);
+                    zstream.next_in = const_cast<Bytef *>(available);
+                    zstream.avail_in = remaining > 0x40000000 ? 0x40000000 : (uInt)remaining;
+                    zstream.next_out = buffer.data + filled;
+                    zstream.avail_out = CAPACITY - filled;
+                    const uInt availableIn = zstream.avail_in;
+                    const uInt availableOut = zstream.avail_out;
+                    const int status = library.inflate(&zstream, Z_NO_FLUSH);
+                    consumed = availableIn - zstream.avail_in;
+                    produced = availableOut - zstream.avail_out;
+                    if(status == Z_STREAM_END) frameEnded = true;
+                    else if(status == Z_OK || status == Z_BUF_ERROR) frameEnded = false;
+                    else {
+                        error = std::string("cannot decompress gzip data, ") + (zstream.msg ? zstream.msg : "corrupt data");
+                        last = true;
+                    }
+                } else if(method_ == zstdMethod) {
+                    ZSTDInput in = { available, remaining, 0 };
+                    ZSTDOutput out = { buffer.data + filled, CAPACITY - filled, 0 };
+                    const size_t status = library.ZSTD_decompressStream(context, &out, &in);
+                    consumed = in.position;
+                    produced = out.position;
+                    if(library.ZSTD_isError(status)) {
+                        error = std::string("cannot decompress zstd data, ") + library.ZSTD_getErrorName(status);
+                        last = true;
+                    } else frameEnded = status == 0;
+                } else {
+                    size_t in = remaining;
+                    size_t out = CAPACITY - filled;
+                    const size_t status = library.LZ4F_decompress(context, buffer.data + filled, &out, available, &in, NULL);
+                    consumed = in;
+                    produced = out;
+                    if(library.LZ4F_isError(status)) {
+                        error = std::string("cannot decompress lz4 data, ") + library.LZ4F_getErrorName(status);
+                        last = true;
+                    } else frameEnded = status == 0;
+                }
+                available += consumed;
+                remaining -= consumed;
+                filled += produced;
+            }
+
+            // hand the buffer to the reader
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                buffer.length = filled;
+                buffer.last = last;
+                buffer.full = true;
+                if(last) {
+                    error_ = error;
+                    finished_ = true;
+                }
+            }
+            changed_.notify_all();
+            if(last) break;
+            index = 1 - index;
+        }
+
+        if(initialized) {
+            switch(method_) {
+            case gzipMethod: library.inflateEnd(&zstream); break;
+            case zstdMethod: library.ZSTD_freeDStream(context); break;
+            case lz4Method: library.LZ4F_freeDecompressionContext(context); break;
+            default: break;
+            }
+        }
+    }
+
+    int fd_;
+    Method method_;
+    Buffer buffers_[2];
+    int next_;                                    // index of the next buffer the reader will take
+    bool free_[2];                                // buffers released by the reader
+    bool finished_;                               // the decompression thread has filled its last buffer
+    bool stopping_;                               // close() has asked the decompression thread to stop
+    std::string error_;
+    std::mutex mutex_;
+    std::condition_variable changed_;
+    std::thread thread_;
+};
+
+} } } }
+
+#endif
@@ -0,0 +1,520 @@
+/*********************************************************************
+ * Copyright (C) 2026 International Business Machines Corporation
+ * All Rights Reserved
+ ********************************************************************/
+
+#ifndef PACKET_FILE_READER_H_
+#define PACKET_FILE_READER_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <string>
+#include <sstream>
+#include <vector>
+#include "PacketFileDecompressor.h"
+
+namespace com { namespace ibm { namespace streamsx { namespace network {
+
+// This class reads packets from a PCAP or pcapng capture file without
+// copying them.  The whole file is mapped into memory, and each packet is
+// returned as a pointer into the mapping:
+//
+//     PacketFileReader reader;
+//     std::string error = reader.open(filename);
+//     PacketFileReader::Record record;
+//     while (reader.next(record)) {
+//       ... record.data, record.captureLength, record.linkType ...
+//     }
+//     if (!reader.error().empty()) ...
+//
+// The mapping is read sequentially, so the kernel reads ahead of the reader
+// and drops pages behind it.  The reader also asks for the next window of
+// the file ahead of time, and releases the window behind it, so that very
+// large files do not accumulate in the process's resident memory.
+//
+// PCAP files may have been written on hosts of either byte order, with
+// microsecond or nanosecond timestamps.  pcapng files may contain several
+// sections, of either byte order, each with several interfaces of different
+// link types and timestamp resolutions.  Each packet is returned with the
+// link type of its interface, and its timestamp in nanoseconds.
+//
+// Files compressed with gzip, zstd or lz4, recognized by their magic
+// numbers, are decompressed as they are read, on a separate thread, into a
+// pair of buffers rather than mapped.  Packets are returned as pointers
+// into those buffers, and are valid until the next call to next(), as for
+// uncompressed files.
+class PacketFileReader {
+public:
+    // link types of packets in capture files, from http://www.tcpdump.org/linktypes.html
+    static const uint32_t linkTypeEthernet = 1;   // ethernet headers
+    static const uint32_t linkTypeRaw = 101;      // IPv4 or IPv6 headers, without link headers
+    static const uint32_t linkTypeLinuxSLL = 113; // Linux 'cooked' capture headers, version 1
+    static const uint32_t linkTypeIPv4 = 228;     // IPv4 headers, without link headers
+    static const uint32_t linkTypeIPv6 = 229;     // IPv6 headers, without link headers
+    static const uint32_t linkTypeLinuxSLL2 = 276; // Linux 'cooked' capture headers, version 2
+
+    enum Format { pcapFormat, pcapngFormat };
+
+    struct Record {
+        const uint8_t *data;                      // address of packet, valid until the next call to next()
+        uint32_t captureLength;                   // length of packet in the file, possibly truncated
+        uint32_t originalLength;                  // length of packet as captured from the network
+        uint32_t seconds;                         // capture time, in seconds since the epoch
+        uint32_t nanoseconds;                     // capture time, nanoseconds within the second
+        uint32_t linkType;                        // link type of the interface the packet was captured on
+        uint32_t interface;                       // index of that interface within its pcapng section, or zero
+    };
+
+    PacketFileReader(): fd_(-1), base_(NULL), size_(0), offset_(0), released_(0), position_(0), streaming_(false), ended_(false), buffer_(NULL), format_(pcapFormat), swapped_(false), nanoseconds_(false), linkType_(0), maximumLength_(0) {}
+
+    ~PacketFileReader() {
+        close();
+    }
+
+    // Maps the capture file 'filename' into memory, or starts decompressing
+    // it, and reads its file header, or the first pcapng section header.
+    // Returns an empty string on success, or an error message.
+    std::string open(const std::string &filename) {
+        close();
+
+        fd_ = ::open(filename.c_str(), O_RDONLY);
+        if(fd_ < 0) return error("cannot open file");
+        offset_ = 0;
+        released_ = 0;
+        position_ = 0;
+        ended_ = false;
+        error_.clear();
+        interfaces_.clear();
+
+        uint8_t head[4];
+        const ssize_t count = pread(fd_, head, sizeof(head), 0);
+        if(count < 0) return error("cannot read file");
+        const PacketFileDecompressor::Method method = PacketFileDecompressor::method(head, count);
+        if(method != PacketFileDecompressor::noMethod) {
+            const std::string problem = decompressor_.open(fd_, method);
+            if(!problem.empty()) {
+                close();
+                return problem;
+            }
+            streaming_ = true;
+        } else {
+            struct stat status;
+            if(fstat(fd_, &status) != 0) return error("cannot get size of file");
+            size_ = status.st_size;
+            if(size_ < sizeof(FileHeader)) {
+                close();
+                return "file is too short for a PCAP file header";
+            }
+
+            void *base = mmap(NULL, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+            if(base == MAP_FAILED) return error("cannot map file into memory");
+            base_ = static_cast<const uint8_t *>(base);
+            madvise(const_cast<uint8_t *>(base_), size_, MADV_SEQUENTIAL);
+            madvise(const_cast<uint8_t *>(base_), size_ < 2 * WINDOW ? size_ : 2 * WINDOW, MADV_WILLNEED);
+        }
+
+        const uint8_t *header = peek(sizeof(FileHeader));
+        if(!header) {
+            const std::string problem = error_.empty() ? "file is too short for a PCAP file header" : error_;
+            close();
+            return problem;
+        }
+
+        // pcapng files begin with a section header block, which is read by
+        // next() like any other block
+        uint32_t magic;
+        memcpy(&magic, header, sizeof(magic));
+        if(magic == SECTION_HEADER_BLOCK) {
+            format_ = pcapngFormat;
+            swapped_ = false;
+            linkType_ = 0;
+            return std::string();
+        }
+
+        FileHeader fileHeader;
+        memcpy(&fileHeader, header, sizeof(fileHeader));
+        switch(fileHeader.magic) {
+        case 0xa1b2c3d4: swapped_ = false; nanoseconds_ = false; break;
+        case 0xd4c3b2a1: swapped_ = true;  nanoseconds_ = false; break;
+        case 0xa1b23c4d: swapped_ = false; nanoseconds_ = true;  break;
+        case 0x4d3cb2a1: swapped_ = true;  nanoseconds_ = true;  break;
+        default: {
+            std::ostringstream message;
+            message << "unrecognized PCAP file magic number 0x" << std::hex << fileHeader.magic;
+            close();
+            return message.str(); }
+        }
+        format_ = pcapFormat;
+        linkType_ = value(fileHeader.linkType) & 0x0000ffff; // upper bits are FCS length and flags
+        maximumLength_ = maximumCaptureLength(value(fileHeader.snapshotLength));
+
+        consume(sizeof(FileHeader));
+        return std::string();
+    }
+
+    void close() {
+        if(streaming_) {
+            decompressor_.close();
+            buffer_ = NULL;
+            spill_.clear();
+        } else if(base_) munmap(const_cast<uint8_t *>(base_), size_);
+        if(fd_ >= 0) ::close(fd_);
+        fd_ = -1;
+        base_ = NULL;
+        size_ = 0;
+        offset_ = 0;
+        streaming_ = false;
+    }
+
+    Format format() const {
+        return format_;
+    }
+
+    // Returns the method the file is compressed with, or 'noMethod'.
+    PacketFileDecompressor::Method compression() const {
+        return streaming_ ? decompressor_.method() : PacketFileDecompressor::noMethod;
+    }
+
+    // Returns the next packet in the file in 'record'.  Returns false at the
+    // end of the file, or if the file is damaged, in which case error()
+    // describes the damage.
+    bool next(Record &record) {
+        return format_ == pcapngFormat ? nextBlock(record) : nextRecord(record);
+    }
+
+    // Returns a description of the damage that stopped next(), or an empty string.
+    const std::string &error() const {
+        return error_;
+    }
+
+private:
+    // the size of the windows the reader asks for ahead of time and releases
+    // behind it, which must be a multiple of the page size
+    static const size_t WINDOW = 64 * 1024 * 1024;
+
+    // pcapng block types, from https://www.ietf.org/archive/id/draft-ietf-opsawg-pcapng-02.html
+    static const uint32_t SECTION_HEADER_BLOCK = 0x0A0D0D0A;
+    static const uint32_t INTERFACE_DESCRIPTION_BLOCK = 1;
+    static const uint32_t PACKET_BLOCK = 2;       // obsolete
+    static const uint32_t SIMPLE_PACKET_BLOCK = 3;
+    static const uint32_t ENHANCED_PACKET_BLOCK = 6;
+    static const uint32_t BYTE_ORDER_MAGIC = 0x1A2B3C4D;
+
+    // the largest packet libpcap will read (its MAXIMUM_SNAPLEN), and the
+    // largest pcapng block it will read (its INITIAL_MAX_BLOCKSIZE), so that
+    // damaged length fields are reported rather than trusted
+    static const uint32_t MAXIMUM_SNAPSHOT_LENGTH = 262144;
+    static const uint32_t MAXIMUM_BLOCK_LENGTH = 16 * 1024 * 1024;
+
+    // pcapng interface description block options
+    static const uint16_t OPTION_END = 0;
+    static const uint16_t OPTION_IF_TSRESOL = 9;
+    static const uint16_t OPTION_IF_TSOFFSET = 14;
+
+    struct FileHeader {
+        uint32_t magic;
+        uint16_t versionMajor;
+        uint16_t versionMinor;
+        int32_t timeZone;
+        uint32_t timestampAccuracy;
+        uint32_t snapshotLength;
+        uint32_t linkType;
+    } __attribute__((packed));
+
+    struct RecordHeader {
+        uint32_t seconds;
+        uint32_t fraction;                        // microseconds or nanoseconds, depending upon magic number
+        uint32_t captureLength;
+        uint32_t originalLength;
+    } __attribute__((packed));
+
+    // a pcapng interface, as described by an interface description block
+    struct Interface {
+        uint32_t linkType;
+        uint32_t snapshotLength;
+        uint32_t maximumLength;                   // largest capture length delivered
+        uint64_t unitsPerSecond;                  // timestamp resolution
+        int64_t offsetSeconds;                    // added to timestamps
+    };
+
+    PacketFileReader(const PacketFileReader &);
+    PacketFileReader &operator=(const PacketFileReader &);
+
+    // reads a packet record from a PCAP file
+    bool nextRecord(Record &record) {
+        if(!peek(1)) return false;
+
+        const uint8_t *block = peek(sizeof(RecordHeader));
+        if(!block) return damaged("truncated record header");
+        RecordHeader header;
+        memcpy(&header, block, sizeof(header));
+        record.captureLength = value(header.captureLength);
+        record.originalLength = value(header.originalLength);
+        record.seconds = value(header.seconds);
+        record.nanoseconds = nanoseconds_ ? value(header.fraction) : value(header.fraction) * 1000;
+        record.linkType = linkType_;
+        record.interface = 0;
+        if(record.captureLength > MAXIMUM_SNAPSHOT_LENGTH) return damaged("invalid packet capture length");
+        block = peek(sizeof(RecordHeader) + (size_t)record.captureLength);
+        if(!block) return damaged("truncated packet");
+        record.data = block + sizeof(RecordHeader);
+        consume(sizeof(RecordHeader) + (size_t)record.captureLength);
+
+        // libpcap truncates records longer than the snapshot length
+        if(record.captureLength > maximumLength_) record.captureLength = maximumLength_;
+        return true;
+    }
+
+    // reads blocks from a pcapng file until one contains a packet
+    bool nextBlock(Record &record) {
+        while(peek(1)) {
+
+            const uint8_t *block = peek(12);
+            if(!block) return damaged("truncated block header");
+            const uint32_t type = value32(block);
+
+            // the byte order of each section is given by its header, and
+            // the section header block's type reads the same in either order
+            if(type == SECTION_HEADER_BLOCK) {
+                const uint32_t magic = read32(block + 8);
+                if(magic == BYTE_ORDER_MAGIC) swapped_ = false;
+                else if(magic == __builtin_bswap32(BYTE_ORDER_MAGIC)) swapped_ = true;
+                else return damaged("unrecognized pcapng byte order magic number");
+                interfaces_.clear();
+            }
+
+            const uint32_t length = value32(block + 4);
+            if(length < 12 || length % 4 || length > MAXIMUM_BLOCK_LENGTH) return damaged("invalid pcapng block length");
+            block = peek(length);
+            if(!block) return damaged("truncated block");
+
+            switch(type) {
+            case INTERFACE_DESCRIPTION_BLOCK:
+                if(length < 20) return damaged("truncated interface description block");
+                addInterface(block, length);
+                break;
+            case ENHANCED_PACKET_BLOCK:
+                if(length < 32) return damaged("truncated enhanced packet block");
+                if(!packet(record, value32(block + 8), block + 12, block + 20, block + 28, length - 32)) return false;
+                consume(length);
+                return true;
+            case PACKET_BLOCK:
+                if(length < 32) return damaged("truncated packet block");
+                if(!packet(record, value16(block + 8), block + 12, block + 20, block + 28, length - 32)) return false;
+                consume(length);
+                return true;
+            case SIMPLE_PACKET_BLOCK: {
+                if(length < 16) return damaged("truncated simple packet block");
+                if(interfaces_.empty()) return damaged("simple packet block without interface");
+                const Interface &interface = interfaces_[0];
+                record.originalLength = value32(block + 8);
+                record.captureLength = record.originalLength;
+                if(interface.snapshotLength && record.captureLength > interface.snapshotLength) record.captureLength = interface.snapshotLength;
+                if(record.captureLength > length - 16) record.captureLength = length - 16;
+                record.data = block + 12;
+                record.seconds = 0; // simple packet blocks do not have timestamps
+                record.nanoseconds = 0;
+                record.linkType = interface.linkType;
+                record.interface = 0;
+                consume(length);
+                return true; }
+            default:
+                break;
+            }
+            consume(length);
+        }
+        return false;
+    }
+
+    // fills in 'record' from the fields of an enhanced or obsolete packet block
+    bool packet(Record &record, uint32_t interfaceIndex, const uint8_t *timestamp, const uint8_t *lengths, const uint8_t *data, uint32_t available) {
+        if(interfaceIndex >= interfaces_.size()) return damaged("packet block for undefined interface");
+        const Interface &interface = interfaces_[interfaceIndex];
+        record.captureLength = value32(lengths);
+        record.originalLength = value32(lengths + 4);
+        if(record.captureLength > MAXIMUM_SNAPSHOT_LENGTH) return damaged("invalid packet capture length");
+        if(record.captureLength > available) return damaged("truncated packet");
+        if(record.captureLength > interface.maximumLength) record.captureLength = interface.maximumLength;
+        record.data = data;
+        record.linkType = interface.linkType;
+        record.interface = interfaceIndex;
+
+        // timestamps are counted in units of the interface's resolution
+        const uint64_t ticks = ((uint64_t)value32(timestamp) << 32) | value32(timestamp + 4);
+        record.seconds = (uint32_t)(ticks / interface.unitsPerSecond + interface.offsetSeconds);
+        record.nanoseconds = (uint32_t)((unsigned __int128)(ticks % interface.unitsPerSecond) * 1000000000u / interface.unitsPerSecond);
+        return true;
+    }
+
+    // adds an interface from an interface description block to the current section
+    void addInterface(const uint8_t *block, uint32_t length) {
+        Interface interface;
+        interface.linkType = value16(block + 8);
+        interface.snapshotLength = value32(block + 12);
+        interface.maximumLength = maximumCaptureLength(interface.snapshotLength);
+        interface.unitsPerSecond = 1000000;
+        interface.offsetSeconds = 0;
+
+        // step through the options, each padded to a multiple of four bytes
+        const uint8_t *option = block + 16;
+        const uint8_t *end = block + length - 4;
+        while(option + 4 <= end) {
+            const uint16_t code = value16(option);
+            const uint16_t size = value16(option + 2);
+            if(code == OPTION_END || option + 4 + size > end) break;
+            if(code == OPTION_IF_TSRESOL && size >= 1) {
+                // the high bit selects a power of two, otherwise a power of ten
+                const uint8_t resolution = option[4];
+                const uint8_t exponent = resolution & 0x7f;
+                if(resolution & 0x80) {
+                    if(exponent < 64) interface.unitsPerSecond = (uint64_t)1 << exponent;
+                } else if(exponent < 20) {
+                    interface.unitsPerSecond = 1;
+                    for(uint8_t i = 0; i < exponent; i++) interface.unitsPerSecond *= 10;
+                }
+            } else if(code == OPTION_IF_TSOFFSET && size >= 8) {
+                uint64_t offset;
+                memcpy(&offset, option + 4, sizeof(offset));
+                interface.offsetSeconds = (int64_t)(swapped_ ? __builtin_bswap64(offset) : offset);
+            }
+            option += 4 + ((size + 3) & ~3);
+        }
+
+        interfaces_.push_back(interface);
+    }
+
+    // returns the largest capture length delivered for a file or interface
+    // with snapshot length 'snapshotLength', which is zero or out of range in
+    // some files; longer records are truncated to it, as libpcap does
+    static uint32_t maximumCaptureLength(uint32_t snapshotLength) {
+        return snapshotLength == 0 || snapshotLength > MAXIMUM_SNAPSHOT_LENGTH ? MAXIMUM_SNAPSHOT_LENGTH : snapshotLength;
+    }
+
+    // returns the address of the next 'length' bytes of the file, or NULL if
+    // the file ends before them
+    const uint8_t *peek(size_t length) {
+        if(length <= size_ - offset_) return base_ + offset_;
+        return streaming_ ? refill(length) : NULL;
+    }
+
+    // takes decompressed buffers until the next 'length' bytes are
+    // contiguous, by copying the unread end of the current buffer into the
+    // headroom before the data of the next one
+    const uint8_t *refill(size_t length) {
+        while(!ended_ && length > size_ - offset_) {
+            PacketFileDecompressor::Buffer *buffer = decompressor_.take();
+            if(!buffer) {
+                ended_ = true;
+                if(!decompressor_.error().empty()) error_ = decompressor_.error();
+                break;
+            }
+            const size_t unread = size_ - offset_;
+            if(unread <= PacketFileDecompressor::HEADROOM) {
+                uint8_t *start = buffer->data - unread;
+                if(unread) memcpy(start, base_ + offset_, unread);
+                if(buffer_) decompressor_.release(buffer_);
+                buffer_ = buffer;
+                base_ = start;
+                size_ = unread + buffer->length;
+            } else {
+                // blocks larger than the headroom are collected in a buffer of their own
+                std::vector<uint8_t> joined(unread + buffer->length);
+                memcpy(&joined[0], base_ + offset_, unread);
+                memcpy(&joined[unread], buffer->data, buffer->length);
+                if(buffer_) decompressor_.release(buffer_);
+                decompressor_.release(buffer);
+                buffer_ = NULL;
+                spill_.swap(joined);
+                base_ = &spill_[0];
+                size_ = spill_.size();
+            }
+            position_ += offset_;
+            offset_ = 0;
+        }
+        return length <= size_ - offset_ ? base_ + offset_ : NULL;
+    }
+
+    // steps over the next 'length' bytes of the file
+    void consume(size_t length) {
+        offset_ += length;
+        if(streaming_) return;
+
+        // once the reader has moved a full window past the last release,
+        // release that window and ask for the one after the reader
+        if(offset_ - released_ >= 2 * WINDOW) {
+            madvise(const_cast<uint8_t *>(base_) + released_, WINDOW, MADV_DONTNEED);
+            released_ += WINDOW;
+            const size_t ahead = released_ + 2 * WINDOW;
+            if(ahead < size_) madvise(const_cast<uint8_t *>(base_) + ahead, size_ - ahead < WINDOW ? size_ - ahead : WINDOW, MADV_WILLNEED);
+        }
+    }
+
+    uint32_t value(uint32_t field) const {
+        return swapped_ ? __builtin_bswap32(field) : field;
+    }
+
+    static uint32_t read32(const uint8_t *field) {
+        uint32_t result;
+        memcpy(&result, field, sizeof(result));
+        return result;
+    }
+
+    uint32_t value32(const uint8_t *field) const {
+        return value(read32(field));
+    }
+
+    uint16_t value16(const uint8_t *field) const {
+        uint16_t result;
+        memcpy(&result, field, sizeof(result));
+        return swapped_ ? __builtin_bswap16(result) : result;
+    }
+
+    bool damaged(const std::string &what) {
+        // an error from the decompressor explains the damage better than its consequences
+        if(error_.empty()) {
+            std::ostringstream message;
+            message << what << " at offset " << position_ + offset_;
+            if(streaming_) message << " of decompressed data";
+            else message << " of " << size_ << " bytes";
+            error_ = message.str();
+        }
+        offset_ = size_;
+        ended_ = true;
+        return false;
+    }
+
+    std::string error(const std::string &what) {
+        std::string message = what + ", " + strerror(errno);
+        close();
+        return message;
+    }
+
+    int fd_;
+    const uint8_t *base_;
+    size_t size_;
+    size_t offset_;
+    size_t released_;
+    size_t position_;                             // offset in the decompressed file of 'base_'
+    bool streaming_;                              // the file is being decompressed rather than mapped
+    bool ended_;                                  // no more decompressed data will be taken
+    PacketFileDecompressor decompressor_;
+    PacketFileDecompressor::Buffer *buffer_;      // the decompressed buffer 'base_' points into, if any
+    std::vector<uint8_t> spill_;                  // a block larger than the headroom, if 'base_' points here
+    Format format_;
+    bool swapped_;
+    bool nanoseconds_;
+    uint32_t linkType_;
+    uint32_t maximumLength_;                      // largest capture length delivered from a PCAP file
+    std::vector<Interface> interfaces_;
+    std::string error_;
+};
+
+} } } }
+
+#endif
@@ -0,0 +1,133 @@
+/*********************************************************************
+ * Copyright (C) 2026 International Business Machines Corporation
+ * All Rights Reserved
+ ********************************************************************/
+
+#ifndef PACKET_PACER_H_
+#define PACKET_PACER_H_
+
+#include <stdint.h>
+#include <time.h>
+#include <sys/prctl.h>
+
+namespace com { namespace ibm { namespace streamsx { namespace network {
+
+// This class paces the replay of recorded packets, either at their original
+// intervals, optionally sped up or slowed down, or at a fixed rate:
+//
+//     PacketPacer pacer;
+//     pacer.setSpeed(2.0);                   // twice as fast as recorded
+//     for (each packet) {
+//       const uint64_t due = pacer.schedule(timestamp);
+//       while (!pacer.waitUntil(due)) if (stopping) break;
+//       ... emit packet ...
+//     }
+//
+// Packets are scheduled relative to the first packet after restart(), so
+// that errors in waking up do not accumulate.  A packet that is already
+// late is due immediately, so the replay catches up after a stall.
+//
+// Waiting sleeps with clock_nanosleep() until shortly before a packet is
+// due, and then spins on the monotonic clock, which is read from the
+// processor's time stamp counter without a system call, so that packets are
+// emitted within a few microseconds of when they are due, despite the
+// latency of waking up from sleep.  The thread's timer slack, by which the
+// kernel may delay its wakeups to coalesce them with others, is reduced to
+// a nanosecond when it schedules its first packet.
+class PacketPacer {
+public:
+    PacketPacer(): speed_(0), period_(0), started_(false), startTime_(0), startTimestamp_(0), count_(0) {}
+
+    // Paces packets at their recorded intervals, divided by 'speed'.
+    void setSpeed(double speed) {
+        speed_ = speed;
+        period_ = 0;
+        restart();
+    }
+
+    // Paces packets at 'rate' packets per second, regardless of their
+    // recorded intervals.
+    void setRate(double rate) {
+        speed_ = 0;
+        period_ = rate > 0 ? 1000000000.0 / rate : 0;
+        restart();
+    }
+
+    bool enabled() const {
+        return speed_ > 0 || period_ > 0;
+    }
+
+    // Schedules the next packet relative to the current time.
+    void restart() {
+        started_ = false;
+    }
+
+    // Returns the time, on the monotonic clock in nanoseconds, at which the
+    // next packet, recorded at 'timestamp' nanoseconds, is due.
+    uint64_t schedule(uint64_t timestamp) {
+        if(!started_) {
+            prctl(PR_SET_TIMERSLACK, 1ul);
+            started_ = true;
+            startTime_ = now();
+            startTimestamp_ = timestamp;
+            count_ = 0;
+            return startTime_;
+        }
+        if(period_ > 0) return startTime_ + (uint64_t)(++count_ * period_);
+        if(timestamp <= startTimestamp_) return startTime_;
+        return startTime_ + (uint64_t)((double)(timestamp - startTimestamp_) / speed_);
+    }
+
+    // Waits until 'due', or for at most 'SLICE' nanoseconds, so that the
+    // caller can check for shutdown while waiting for widely spaced
+    // packets.  Returns true when 'due' has come.
+    bool waitUntil(uint64_t due) const {
+        uint64_t time = now();
+        if(time >= due) return true;
+
+        if(due - time > SPIN) {
+            const uint64_t wake = due - time > SLICE + SPIN ? time + SLICE : due - SPIN;
+            struct timespec until;
+            until.tv_sec = wake / 1000000000ul;
+            until.tv_nsec = wake % 1000000000ul;
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &until, NULL);
+            time = now();
+            if(time < due && due - time > SPIN) return false;
+        }
+
+        while(now() < due) pause();
+        return true;
+    }
+
+    // Returns the time on the monotonic clock in nanoseconds.
+    static uint64_t now() {
+        struct timespec time;
+        clock_gettime(CLOCK_MONOTONIC, &time);
+        return (uint64_t)time.tv_sec * 1000000000ul + time.tv_nsec;
+    }
+
+private:
+    enum {
+        SPIN = 100000,                            // nanoseconds before a packet is due to stop sleeping and start spinning
+        SLICE = 100000000                         // longest sleep, in nanoseconds
+    };
+
+    static void pause() {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#elif defined(__powerpc64__)
+        __asm__ __volatile__("or 27,27,27" ::: "memory"); // yield to other hardware threads
+#endif
+    }
+
+    double speed_;
+    double period_;                               // nanoseconds between packets, at a fixed rate
+    bool started_;
+    uint64_t startTime_;                          // monotonic time of the first packet
+    uint64_t startTimestamp_;                     // recorded time of the first packet
+    uint64_t count_;                              // packets scheduled since the first, at a fixed rate
+};
+
+} } } }
+
+#endif
@@ -9,88 +9,196 @@
 #include <stdint.h>
 #include <string.h>
 #include <assert.h>
+#include <errno.h>
+#include <unistd.h>
 #include <atomic>
+#include <string>
+#include <time.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
 #include <sys/uio.h>
 
 class PacketRingBuffer {
 public:
     // The entry size and entry count must be powers of 2 for everything to work out right.
+    // These are the defaults; open() can be given others.
     static const size_t ENTRY_SIZE_BITS = 7;
     static const size_t ENTRY_COUNT_BITS = 19;    // 2^15 x 128 byte entries would allow 8 rings to fit in the L3 of one socket, but that's pretty small.
     static const size_t ENTRY_SIZE = 1 << ENTRY_SIZE_BITS;
     static const size_t ENTRY_COUNT = 1 << ENTRY_COUNT_BITS;
-    static_assert(ENTRY_SIZE > sizeof(uint32_t)*2, "PacketRingBuffer::ENTRY_SIZE must be large enough for the entry header.");
-    static_assert(ENTRY_SIZE >= 64, "PacketRingBuffer::ENTRY_SIZE must be at least the size of a cache line.");
+    static const size_t MIN_ENTRY_SIZE = 64;      // the size of a cache line
+    static const size_t MAX_ENTRY_SIZE = 65536;
+    static const size_t MIN_ENTRY_COUNT = 1024;
 
     typedef void (*callback_t)(void* user_data, void* pkt_data, uint32_t pkt_len);
 
+    // What the producer does when a packet does not fit in the ring:
+    //   DROP_NEWEST: drops the packet.
+    //   DROP_OLDEST: drops the packet, and has the consumer discard the oldest
+    //                packets in the ring, until it is no more than half full,
+    //                before it takes any more, so that it catches up with the
+    //                newest packets.
+    //   SAMPLE:      drops the packet, and while the ring is more than half full,
+    //                keeps only one packet in every 'sampling' after that.
+    //   BLOCK:       waits for the consumer to make room, for up to 'timeout'
+    //                nanoseconds, and then drops the packet.
+    enum overflow_policy_t { DROP_NEWEST, DROP_OLDEST, SAMPLE, BLOCK };
+
 protected:
     // This entry represents just the initial entry of a given packet in the ring
-    // the other entries are just raw data (in 128 byte chunks), right after this one.
+    // the other entries are just raw data (in entry size chunks), right after this one.
     struct entry {
         uint32_t data_len;
         uint32_t dummy_packet;   // Indicates (=1) this is not actually packet data, and just used to pad the ring.  Ignore on dequeue. 0 otherwise
-        uint8_t data[ENTRY_SIZE - sizeof(uint32_t)*2];
-    } __attribute__((aligned(128),packed));
+        uint8_t data[];
+    } __attribute__((packed));
 
 protected:
+    // Helper to find an entry in the ring
+    inline entry& at(size_t index) const {
+        return *(entry*)(buffer + (index << entry_size_bits));
+    }
+
     // Helper to compute lengths in the ring, including around the end
-    static constexpr inline size_t length(size_t a, size_t b) {
-        return ((b - a) & (ENTRY_COUNT - 1));
+    inline size_t length(size_t a, size_t b) const {
+        return ((b - a) & (entry_count - 1));
     }
 
     // Helper to compute the appropriate next index in the ring, including around the end
-    static constexpr inline size_t next(size_t index, size_t offset) {
-        return ((index + offset) & (ENTRY_COUNT - 1));
+    inline size_t next(size_t index, size_t offset) const {
+        return ((index + offset) & (entry_count - 1));
     }
 
     // Helper to compute the amount of space currently used in the ring
     // This is used on the consumer side, and yields a lower bound, since
     // the producer may still be adding things.
-    static constexpr inline size_t used_size(size_t head, size_t tail) {
+    inline size_t used_size(size_t head, size_t tail) const {
         return length(tail, head);
     }
 
     // Helper to compute the amount of space currently left in the ring
     // This is used on the producer side, and yields a lower bound, since
     // the consumer may be making more room right now.
-    static constexpr inline size_t free_space(size_t head, size_t tail) {
+    inline size_t free_space(size_t head, size_t tail) const {
         return length(head + 1, tail);
     }
 
     // Helper to compute the amount of space current left in the ring UP TO BUT NOT PAST THE END OF THE RING!
     // This is used on the producer side, and yields a lower bound, since
     // the consumer may be making more room right now.
-    static inline size_t free_space_contiguous(size_t head, size_t tail) {
-        size_t tentative_space = ENTRY_COUNT - (head + 1);
-        size_t total_free_space = (tentative_space + tail) & (ENTRY_COUNT - 1);  // tricky, but if head/tail turned into references to the actual items, ensures each is only read once.
+    inline size_t free_space_contiguous(size_t head, size_t tail) const {
+        size_t tentative_space = entry_count - (head + 1);
+        size_t total_free_space = (tentative_space + tail) & (entry_count - 1);  // tricky, but if head/tail turned into references to the actual items, ensures each is only read once.
         return ((total_free_space <= tentative_space) ? total_free_space : (tentative_space + 1));
     }
 
-    // Helper to convert actual data lengths into the count of ENTRY_SIZE items needed to store it.
+    // Helper to convert actual data lengths into the count of entry size items needed to store it.
     // Takes into account the header in front of the first entry.
-    static constexpr inline size_t computeEntryCount(size_t data_len) {
-        return (((data_len + sizeof(uint32_t)*2 - 1) >> ENTRY_SIZE_BITS) + 1);
+    inline size_t computeEntryCount(size_t data_len) const {
+        return (((data_len + sizeof(uint32_t)*2 - 1) >> entry_size_bits) + 1);
     }
 
-    // Helper to convert entry counts of ENTRY_SIZE items into a data length.
+    // Helper to convert entry counts of entry size items into a data length.
     // Takes into account the header in front of the first entry.
     // This is particularly used when padding the end of the ring, before
     // adding an item that is too big for the current space left at the end of the ring.
-    static constexpr inline size_t computeDummyLength(size_t count) {
-        return ((count << ENTRY_SIZE_BITS) - sizeof(uint32_t)*2);
+    inline size_t computeDummyLength(size_t count) const {
+        return ((count << entry_size_bits) - sizeof(uint32_t)*2);
     }
 
 public:
-    PacketRingBuffer(): buffer(new entry[ENTRY_COUNT]), head(0), tail(0) {
-        // Make sure the new didn't fail.  We are potentially getting quite a bit of memory here.
-        assert(buffer);
-    }
+    PacketRingBuffer(): buffer(NULL), entry_size_bits(0), entry_count(0), mapped_size(0), page_kind(""),
+                        head(0), reserved(0), reserved_len(0), overflow_policy(DROP_NEWEST), overflow_sampling(1), overflow_timeout(0), sample_count(0), wakeups(false),
+                        tail(0), peeked(0), idle_polls(0), empty_polls(0), flushed(0), flush_requested(0), sleeping(0) {}
 
     ~PacketRingBuffer() {
-        delete [] buffer;
+        if(buffer) munmap(buffer, mapped_size);
     }
 
+    // Allocates the ring, with 'entrySize' byte entries, and room for 'entryCount' of them.
+    // Both must be powers of 2.  The ring is allocated on 1GB hugepages if it is that
+    // big, or else on 2MB hugepages, if the system has any free, or else on ordinary
+    // pages, and placed in the memory of NUMA node 'numaNode', if not negative.
+    // Returns an empty string if successful, or a description of the error otherwise.
+    std::string open(size_t entrySize = ENTRY_SIZE, size_t entryCount = ENTRY_COUNT, int numaNode = -1) {
+        if(buffer) return "ring buffer is already allocated";
+        if(entrySize < MIN_ENTRY_SIZE || entrySize > MAX_ENTRY_SIZE || (entrySize & (entrySize - 1))) {
+            return "ring buffer entry size " + std::to_string(entrySize) + " is not a power of 2 from " + std::to_string(MIN_ENTRY_SIZE) + " to " + std::to_string(MAX_ENTRY_SIZE);
+        }
+        if(entryCount < MIN_ENTRY_COUNT || (entryCount & (entryCount - 1))) {
+            return "ring buffer entry count " + std::to_string(entryCount) + " is not a power of 2 of at least " + std::to_string(MIN_ENTRY_COUNT);
+        }
+        if(entryCount > SIZE_MAX / entrySize) return "ring buffer is too large";
+
+        const size_t size = entrySize * entryCount;
+        void *memory = MAP_FAILED;
+        if(size >= HUGE_1GB) {
+            mapped_size = roundUp(size, HUGE_1GB);
+            memory = mmap(NULL, mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | (30 << MAP_HUGE_SHIFT), -1, 0);
+            page_kind = "1GB hugepages";
+        }
+        if(memory == MAP_FAILED) {
+            mapped_size = roundUp(size, HUGE_2MB);
+            memory = mmap(NULL, mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | (21 << MAP_HUGE_SHIFT), -1, 0);
+            page_kind = "2MB hugepages";
+        }
+        if(memory == MAP_FAILED) {
+            // No hugepages are reserved; ask for transparent hugepages instead.
+            mapped_size = size;
+            memory = mmap(NULL, mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if(memory == MAP_FAILED) return std::string("could not allocate ring buffer, ") + strerror(errno);
+            madvise(memory, mapped_size, MADV_HUGEPAGE);
+            page_kind = "ordinary pages";
+        }
+
+        // Prefer, rather than bind to, the node, since hugepages that are not
+        // available on it would otherwise fault when touched.
+        if(numaNode >= 0 && numaNode < (int)(sizeof(unsigned long) * 8 * NODE_MASK_WORDS)) {
+            unsigned long nodeMask[NODE_MASK_WORDS] = { 0 };
+            nodeMask[numaNode / (sizeof(unsigned long) * 8)] = 1ul << (numaNode % (sizeof(unsigned long) * 8));
+            syscall(SYS_mbind, memory, mapped_size, PREFERRED_POLICY, nodeMask, sizeof(nodeMask) * 8, 0);
+        }
+
+        // Touch the whole ring now, so its pages are not faulted in while packets arrive.
+        memset(memory, 0, mapped_size);
+
+        buffer = (uint8_t*)memory;
+        entry_size_bits = __builtin_ctzl(entrySize);
+        entry_count = entryCount;
+        return "";
+    }
+
+    // Describes the pages the ring was allocated on.
+    const char* pages() const { return page_kind; }
+
+    // The size of the ring, in entries, and the size of each entry, in bytes.
+    size_t capacity() const { return entry_count; }
+    size_t entrySize() const { return (size_t)1 << entry_size_bits; }
+
+    // Sets what the producer does when a packet does not fit in the ring.
+    // Call this before the producer starts.
+    void setOverflowPolicy(overflow_policy_t policy, uint32_t sampling = 1, uint64_t timeout = 0) {
+        overflow_policy = policy;
+        overflow_sampling = sampling ? sampling : 1;
+        overflow_timeout = timeout;
+    }
+
+    // Has idle() put the consumer to sleep after 'polls' consecutive empty polls,
+    // and the producer wake it when it adds packets; zero, the default, keeps the
+    // consumer spinning.  Call this before the producer and consumer start.
+    // Once enabled, every produce(), produceMulti() and commit() that adds packets
+    // pays for a full memory fence in wake() (an mfence on x86), even while the
+    // consumer is awake; with zero they pay nothing.
+    void setIdlePolls(size_t polls) {
+        idle_polls = polls;
+        wakeups = polls > 0;
+    }
+
+    // The count of packets the consumer discarded from the ring under the DROP_OLDEST policy.
+    uint64_t flushedCount() const {
+        return flushed.load(std::memory_order_relaxed);
+    }
 
     // Just gets a live estimate of the current number of items in the ring
     // From the consumer thread, this is a lower bound, since the producer
@@ -99,9 +207,101 @@ public:
         return used_size(head.load(std::memory_order_relaxed), tail.load(std::memory_order_relaxed));
     }
 
-    // Produces an item onto the buffer, if there is room for it
+    // Produces an item onto the buffer, if there is room for it, or if the
+    // overflow policy makes room for it.
     // Returns true if the item could be added, false otherwise
     bool produce(void *data, uint32_t len) {
+        if(__builtin_expect(overflow_policy == SAMPLE, 0) && !admit()) return false;
+
+        bool produced = tryProduce(data, len);
+        if(__builtin_expect(!produced, 0)) {
+            uint64_t deadline = 0;
+            while(!produced && overflowed(deadline)) produced = tryProduce(data, len);
+        }
+
+        if(wakeups && produced) wake();
+        return produced;
+    }
+
+    // Produces multiple items onto the buffer, to the extent there is room, or
+    // the overflow policy makes room.
+    // Returns the count of produced items.  Under the SAMPLE policy, the items that
+    // were not produced are not necessarily the last ones in the vector.
+    size_t produceMulti(const struct iovec *vector, size_t count) {
+        size_t produced;
+        if(__builtin_expect(overflow_policy == SAMPLE, 0) && underPressure()) {
+            produced = 0;
+            for(size_t i = 0; i < count; ++i) {
+                if(++sample_count % overflow_sampling == 0) produced += tryProduceMulti(&vector[i], 1);
+            }
+        } else {
+            produced = tryProduceMulti(vector, count);
+            if(__builtin_expect(produced < count, 0)) {
+                uint64_t deadline = 0;
+                while(produced < count && overflowed(deadline)) produced += tryProduceMulti(vector + produced, count - produced);
+            }
+        }
+
+        if(wakeups && produced) wake();
+        return produced;
+    }
+
+    // Reserves room for a packet of up to len bytes at the head of the buffer,
+    // so the producer can write it in place rather than copying it in.
+    // Returns a pointer to the room, or NULL if the buffer is full, after applying
+    // the overflow policy.
+    // Nothing is visible to the consumer until commit() is called; a reservation
+    // that is never committed is simply replaced by the next one.
+    uint8_t *reserve(uint32_t len) {
+        if(__builtin_expect(overflow_policy == SAMPLE, 0) && !admit()) return NULL;
+
+        uint8_t *room = tryReserve(len);
+        if(__builtin_expect(!room, 0)) {
+            uint64_t deadline = 0;
+            while(!room && overflowed(deadline)) room = tryReserve(len);
+        }
+        return room;
+    }
+
+    // Publishes the packet written into the last reservation to the consumer.
+    // The packet's actual length may be less than the length reserved.
+    void commit(uint32_t len) {
+        assert(len <= reserved_len);
+        at(reserved).data_len = len;
+        at(reserved).dummy_packet = 0; // Real packet.
+
+        // Update head
+        head.store(next(reserved, computeEntryCount(len)), std::memory_order_release);
+
+        if(wakeups) wake();
+    }
+
+    // Puts the consumer to sleep, for up to 'timeout' nanoseconds, or until the
+    // producer adds packets, once it has polled the ring and found it empty
+    // the number of times given to setIdlePolls().  Call this from the consumer
+    // each time peek() finds nothing.
+    void idle(uint64_t timeout) {
+        if(!wakeups || ++empty_polls < idle_polls) return;
+
+        // Tell the producer we are going to sleep, then check once more that
+        // the ring is empty, so that a packet added in between is not missed.
+        sleeping.store(1, std::memory_order_seq_cst);
+        if(used_size(head.load(std::memory_order_seq_cst), tail.load(std::memory_order_relaxed)) == 0) {
+            struct timespec wait;
+            wait.tv_sec = timeout / 1000000000ul;
+            wait.tv_nsec = timeout % 1000000000ul;
+            syscall(SYS_futex, (uint32_t*)&sleeping, FUTEX_WAIT_PRIVATE, 1, &wait, NULL, 0);
+        }
+        sleeping.store(0, std::memory_order_relaxed);
+
+        // Go straight back to sleep if the ring is still empty.
+        empty_polls = idle_polls - 1;
+    }
+
+protected:
+    // Produces an item onto the buffer, if there is room for it
+    // Returns true if the item could be added, false otherwise
+    bool tryProduce(void *data, uint32_t len) {
         size_t needed_space = computeEntryCount(len);
         size_t lhead = head.load(std::memory_order_relaxed);
         size_t ltail = tail.load(std::memory_order_acquire);
@@ -122,8 +322,8 @@ public:
                 return false;
             } else {
                 // Seems like it will.  Let's insert a dummy to wrap the buffer.
-                buffer[lhead].data_len = computeDummyLength(free_space_end);
-                buffer[lhead].dummy_packet = 1; // This is just a dummy padding packet
+                at(lhead).data_len = computeDummyLength(free_space_end);
+                at(lhead).dummy_packet = 1; // This is just a dummy padding packet
 
                 // Update head (local and actual)
                 lhead = next(lhead, free_space_end);
@@ -133,9 +333,9 @@ public:
 
         // At this point, we know we should fit, contiguously, at the current lhead, or we would
         // have returned already.  We may have already inserted a dummy padding packet.
-        buffer[lhead].data_len = len;
-        buffer[lhead].dummy_packet = 0; // Real packet.
-        memcpy(buffer[lhead].data, data, len);
+        at(lhead).data_len = len;
+        at(lhead).dummy_packet = 0; // Real packet.
+        memcpy(at(lhead).data, data, len);
 
         // Update head
         head.store(next(lhead, needed_space), std::memory_order_release);
@@ -150,7 +350,7 @@ public:
     // consuming more entries after we start producing, but we will
     // only produce up to the point of entries that were free
     // at the time we started.
-    size_t produceMulti(const struct iovec *vector, size_t count) {
+    size_t tryProduceMulti(const struct iovec *vector, size_t count) {
         size_t lhead = head.load(std::memory_order_relaxed);
         size_t ltail = tail.load(std::memory_order_acquire);
         size_t slots_available = free_space(lhead, ltail);
@@ -183,8 +383,8 @@ public:
                     return packets_produced;
                 } else {
                     // Seems like it will fit in the front.  Let's insert a dummy to wrap the buffer.
-                    buffer[lhead].data_len = computeDummyLength(slots_available_end);
-                    buffer[lhead].dummy_packet = 1; // This is just a dummy padding packet
+                    at(lhead).data_len = computeDummyLength(slots_available_end);
+                    at(lhead).dummy_packet = 1; // This is just a dummy padding packet
 
                     // Update just local variables for now.
                     lhead = next(lhead, slots_available_end);
@@ -196,9 +396,9 @@ public:
 
             // At this point, we know we should fit, contiguously, at the current lhead, or we would
             // have returned already.  We may have already inserted a dummy padding packet.
-            buffer[lhead].data_len = vector[packets_produced].iov_len;
-            buffer[lhead].dummy_packet = 0; // Real packet.
-            memcpy(buffer[lhead].data, vector[packets_produced].iov_base, vector[packets_produced].iov_len);
+            at(lhead).data_len = vector[packets_produced].iov_len;
+            at(lhead).dummy_packet = 0; // Real packet.
+            memcpy(at(lhead).data, vector[packets_produced].iov_base, vector[packets_produced].iov_len);
 
             // Update just local variables for now.
             lhead = next(lhead, needed_slots);
@@ -220,23 +420,163 @@ public:
         return packets_produced;
     }
 
+    // Reserves room for a packet of up to len bytes at the head of the buffer.
+    // Returns a pointer to the room, or NULL if the buffer is full.
+    uint8_t *tryReserve(uint32_t len) {
+        size_t needed_space = computeEntryCount(len);
+        size_t lhead = head.load(std::memory_order_relaxed);
+        size_t ltail = tail.load(std::memory_order_acquire);
+        size_t space = free_space(lhead, ltail);
+        size_t free_space_end = free_space_contiguous(lhead, ltail);
+
+        if(__builtin_expect(needed_space > free_space_end, 0)) {
+            // Doesn't fit in the ring contiguously at the end.
+            // Same as produce(), pad the end of the ring if it will fit at the front.
+            if(__builtin_expect(needed_space > (space - free_space_end), 0)) {
+                return NULL;
+            }
+            at(lhead).data_len = computeDummyLength(free_space_end);
+            at(lhead).dummy_packet = 1;
+
+            lhead = next(lhead, free_space_end);
+            head.store(lhead, std::memory_order_release);
+        }
+
+        reserved = lhead;
+        reserved_len = len;
+        return at(lhead).data;
+    }
+
+    // Applies the overflow policy when a packet does not fit in the ring.
+    // Returns true if the producer should try again.
+    bool overflowed(uint64_t& deadline) {
+        switch(overflow_policy) {
+        case DROP_OLDEST:
+            // Only the consumer may move the tail, so ask it to discard the oldest packets.
+            flush_requested.store(1, std::memory_order_relaxed);
+            if(wakeups) wake();
+            return false;
+        case BLOCK:
+            if(!deadline) deadline = now() + overflow_timeout;
+            if(wakeups) wake();
+            if(now() >= deadline) return false;
+            pause();
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    // Decides whether to keep a packet under the SAMPLE policy.
+    bool admit() {
+        return !underPressure() || ++sample_count % overflow_sampling == 0;
+    }
+
+    // Returns true when the ring is more than half full.
+    bool underPressure() const {
+        return used_size(head.load(std::memory_order_relaxed), tail.load(std::memory_order_acquire)) > entry_count / 2;
+    }
+
+    // Wakes the consumer, if it is asleep in idle().
+    void wake() {
+        // Publishing head and then checking whether the consumer is asleep must not be
+        // reordered, or the consumer could go to sleep just after we checked.  This
+        // fence is the cost of wakeups when the consumer is awake, see setIdlePolls().
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if(__builtin_expect(sleeping.load(std::memory_order_relaxed), 0)) {
+            sleeping.store(0, std::memory_order_relaxed);
+            syscall(SYS_futex, (uint32_t*)&sleeping, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+        }
+    }
+
+    // Discards the oldest packets in the ring, until it is no more than half full,
+    // when the producer has asked for it under the DROP_OLDEST policy.
+    void flush() {
+        flush_requested.store(0, std::memory_order_relaxed);
+        const size_t lhead = head.load(std::memory_order_acquire);
+        size_t ltail = tail.load(std::memory_order_relaxed);
+
+        uint64_t packets = 0;
+        while(used_size(lhead, ltail) > entry_count / 2) {
+            if(at(ltail).dummy_packet != 1) ++packets;
+            ltail = next(ltail, computeEntryCount(at(ltail).data_len));
+        }
+        flushed.fetch_add(packets, std::memory_order_relaxed);
+        tail.store(ltail, std::memory_order_release);
+    }
+
+    static uint64_t now() {
+        struct timespec time;
+        clock_gettime(CLOCK_MONOTONIC, &time);
+        return (uint64_t)time.tv_sec * 1000000000ul + time.tv_nsec;
+    }
+
+    static void pause() {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#elif defined(__powerpc64__)
+        __asm__ __volatile__("or 27,27,27" ::: "memory");
+#endif
+    }
+
+public:
+
+    // Peeks at up to count packets at the tail of the buffer, without removing them,
+    // so the consumer can use them in place rather than copying them out.
+    // Returns the count of packets, and stores their addresses and lengths in vector.
+    // The packets remain valid, and the producer will not overwrite them, until release()
+    // is called.  Takes a single head snapshot, like consumeAll().
+    size_t peek(struct iovec *vector, size_t count) {
+        if(__builtin_expect(flush_requested.load(std::memory_order_relaxed), 0)) flush();
+
+        size_t ltail = tail.load(std::memory_order_relaxed);
+        size_t items_available = used_size(head.load(std::memory_order_acquire), ltail);
+        size_t items_peeked = 0;
+        size_t packets_peeked = 0;
+
+        while((items_peeked < items_available) && (packets_peeked < count)) {
+            size_t skip_len = computeEntryCount(at(ltail).data_len);
+
+            if(__builtin_expect(at(ltail).dummy_packet != 1, 1)) {
+                vector[packets_peeked].iov_base = at(ltail).data;
+                vector[packets_peeked].iov_len = at(ltail).data_len;
+                ++packets_peeked;
+            } // else a dummy.  Have to keep going.  Unlikely path.
+
+            ltail = next(ltail, skip_len);
+            items_peeked += skip_len;
+        }
+
+        peeked = ltail;
+        if(packets_peeked) empty_polls = 0;
+        return packets_peeked;
+    }
+
+    // Removes the packets returned by the last peek() from the buffer, making their
+    // room available to the producer again.
+    void release() {
+        tail.store(peeked, std::memory_order_release);
+    }
+
     // Consumes one item from the buffer, if there was an item to consume
     // Returns true if an item was consumed, false otherwise.
     // Calls cb for each packet before removing it from the buffer (if cb specified)
     bool consume(callback_t cb, void *user_data) {
+        if(__builtin_expect(flush_requested.load(std::memory_order_relaxed), 0)) flush();
+
         do {
             size_t ltail = tail.load(std::memory_order_relaxed);
             if(used_size(head.load(std::memory_order_acquire), ltail) >= 1) {
                 // Found something in the buffer!
-                size_t skip_len = computeEntryCount(buffer[ltail].data_len);
-                bool dummy_packet = (buffer[ltail].dummy_packet == 1);
+                size_t skip_len = computeEntryCount(at(ltail).data_len);
+                bool dummy_packet = (at(ltail).dummy_packet == 1);
 
                 if(__builtin_expect(!dummy_packet, 1)) {
                     // Real packet!
 
                     // Use the callback on it (if there is one)
                     if(__builtin_expect(cb != NULL, 1)) {
-                        cb(user_data, buffer[ltail].data, buffer[ltail].data_len);
+                        cb(user_data, at(ltail).data, at(ltail).data_len);
                     } // else no callback? Unlikely.
 
                 } // else a dummy.  Have to keep going.  Unlikely path.
@@ -266,6 +606,8 @@ public:
     // only consume up to the point of entries that had been produced
     // at the time we started.
     size_t consumeAll(callback_t cb, void *user_data, size_t max_burst = 0) {
+        if(__builtin_expect(flush_requested.load(std::memory_order_relaxed), 0)) flush();
+
         size_t ltail = tail.load(std::memory_order_relaxed);
         size_t items_available = used_size(head.load(std::memory_order_acquire), ltail);
         size_t items_consumed = 0;
@@ -273,15 +615,15 @@ public:
 
         // We won't attempt to predict this while loop clause ... empty queue might be just as likely as one thing in queue, and a whole bunch in queue.
         while((items_consumed < items_available) && ((max_burst == 0) || (packets_consumed < max_burst))) {
-            size_t skip_len = computeEntryCount(buffer[ltail].data_len);
-            bool dummy_packet = (buffer[ltail].dummy_packet == 1);
+            size_t skip_len = computeEntryCount(at(ltail).data_len);
+            bool dummy_packet = (at(ltail).dummy_packet == 1);
 
             if(__builtin_expect(!dummy_packet, 1)) {
                 // Real packet!
 
                 // Use the callback on it (if there is one)
                 if(__builtin_expect(cb != NULL, 1)) {
-                    cb(user_data, buffer[ltail].data, buffer[ltail].data_len);
+                    cb(user_data, at(ltail).data, at(ltail).data_len);
                 } // else no callback? Unlikely.
 
                 ++packets_consumed;
@@ -303,10 +645,42 @@ public:
     }
 
 protected:
-    struct entry * const buffer __attribute__((aligned(64)));
+    enum {
+        HUGE_2MB = 1 << 21,
+        HUGE_1GB = 1 << 30,
+        PREFERRED_POLICY = 1,   // MPOL_PREFERRED, from <numaif.h>, which needs libnuma
+        NODE_MASK_WORDS = 16
+    };
+
+    static size_t roundUp(size_t size, size_t unit) {
+        return (size + unit - 1) & ~(unit - 1);
+    }
+
+    // These are set by open(), and not changed after.
+    uint8_t *buffer __attribute__((aligned(64)));
+    size_t entry_size_bits;
+    size_t entry_count;
+    size_t mapped_size;
+    const char *page_kind;
 
     std::atomic<size_t> head __attribute__((aligned(64)));
+    size_t reserved;         // Producer only: index of the entry returned by reserve()
+    uint32_t reserved_len;   // Producer only: length passed to reserve()
+    overflow_policy_t overflow_policy;
+    uint32_t overflow_sampling;
+    uint64_t overflow_timeout;
+    uint64_t sample_count;   // Producer only: packets seen while sampling
+    bool wakeups;            // the consumer may be asleep in idle()
+
     std::atomic<size_t> tail __attribute__((aligned(64)));
+    size_t peeked;           // Consumer only: index just past the packets returned by peek()
+    size_t idle_polls;
+    size_t empty_polls;      // Consumer only: consecutive polls that found the ring empty
+    std::atomic<uint64_t> flushed;
+
+    // Written by both sides, so kept apart from head and tail.
+    std::atomic<uint32_t> flush_requested __attribute__((aligned(64)));  // the producer asked the consumer to discard the oldest packets
+    std::atomic<uint32_t> sleeping __attribute__((aligned(64)));         // the consumer is asleep, or about to be, on this futex
 };
 
 
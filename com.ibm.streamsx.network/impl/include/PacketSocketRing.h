@@ -0,0 +1,284 @@
+/*********************************************************************
+ * Copyright (C) 2026 International Business Machines Corporation
+ * All Rights Reserved
+ ********************************************************************/
+
+#ifndef PACKET_SOCKET_RING_H_
+#define PACKET_SOCKET_RING_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <net/if.h>
+#include <arpa/inet.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <linux/if_ether.h>
+#include <linux/if_packet.h>
+#include <linux/filter.h>
+#include <linux/bpf.h>
+#include <string>
+
+namespace com { namespace ibm { namespace streamsx { namespace network {
+
+// This class receives packets from a network interface through a Linux
+// AF_PACKET socket with a TPACKET_V3 receive ring.
+//
+// The kernel copies packets into a ring of blocks shared with user space,
+// and hands a block over when it is full or when its timeout expires.  The
+// receiver then walks all packets in the block in place, without a system
+// call or callback per packet, and gives the block back to the kernel:
+//
+//     struct tpacket_block_desc* block = ring.nextBlock(timeout);
+//     if (block) {
+//       for (struct tpacket3_hdr* packet = ring.firstPacket(block); packet; packet = ring.nextPacket(packet)) {
+//         ... ring.packetData(packet), packet->tp_snaplen, packet->tp_len ...
+//       }
+//       ring.releaseBlock(block);
+//     }
+//
+// The kernel strips VLAN tags from received packets and passes them on the
+// side.  Like libpcap, packetData() puts them back in front of the packet
+// data, using headroom reserved in each frame, and adjusts the packet's
+// lengths, so the data looks as it did on the wire.
+//
+// Several sockets on the same interface may join a fanout group, and the
+// kernel then spreads the interface's packets across their rings, so that
+// each ring can be drained by its own thread.
+//
+// One thread may receive from a ring, and another may call statistics().
+class PacketSocketRing {
+public:
+    enum { VLAN_TAG_LENGTH = 4 };
+
+    PacketSocketRing(): fd_(-1), ring_(NULL), ringSize_(0), blockSize_(0), blockCount_(0), currentBlock_(0), packets_(0), drops_(0) {}
+
+    ~PacketSocketRing() {
+        close();
+    }
+
+    // Opens a socket on 'interface' with a ring of 'blockCount' blocks of
+    // 'blockSize' bytes each.  The block size must be a multiple of the page
+    // size, and a power of two.  A block is handed to user space when it
+    // fills up, or 'blockTimeout' milliseconds after its first packet
+    // arrived.  If 'filter' is not NULL, it is attached to the socket as a
+    // classic BPF program before the socket is bound to the interface.
+    // Returns an empty string on success, or an error message.
+    std::string open(const std::string &interface, size_t blockSize, size_t blockCount, unsigned blockTimeout, bool promiscuous, const struct sock_fprog *filter) {
+        close();
+
+        const int ifindex = if_nametoindex(interface.c_str());
+        if(!ifindex) return "cannot find network interface '" + interface + "', " + strerror(errno);
+
+        fd_ = socket(AF_PACKET, SOCK_RAW, htons(ETH_P_ALL));
+        if(fd_ < 0) return error("cannot create packet socket");
+
+        int version = TPACKET_V3;
+        if(setsockopt(fd_, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) != 0) return error("cannot select TPACKET_V3");
+
+        unsigned reserve = VLAN_TAG_LENGTH;
+        if(setsockopt(fd_, SOL_PACKET, PACKET_RESERVE, &reserve, sizeof(reserve)) != 0) return error("cannot reserve VLAN tag headroom");
+
+        struct tpacket_req3 request;
+        memset(&request, 0, sizeof(request));
+        request.tp_block_size = blockSize;
+        request.tp_block_nr = blockCount;
+        request.tp_frame_size = TPACKET_ALIGNMENT << 7;
+        request.tp_frame_nr = (blockSize / request.tp_frame_size) * blockCount;
+        request.tp_retire_blk_tov = blockTimeout;
+        if(setsockopt(fd_, SOL_PACKET, PACKET_RX_RING, &request, sizeof(request)) != 0) return error("cannot create receive ring");
+
+        ringSize_ = blockSize * blockCount;
+        void *ring = mmap(NULL, ringSize_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+        if(ring == MAP_FAILED) {
+            ringSize_ = 0;
+            return error("cannot map receive ring");
+        }
+        ring_ = static_cast<uint8_t *>(ring);
+        blockSize_ = blockSize;
+        blockCount_ = blockCount;
+        currentBlock_ = 0;
+
+        if(filter && setsockopt(fd_, SOL_SOCKET, SO_ATTACH_FILTER, filter, sizeof(*filter)) != 0) return error("cannot attach input filter");
+
+        struct sockaddr_ll address;
+        memset(&address, 0, sizeof(address));
+        address.sll_family = AF_PACKET;
+        address.sll_protocol = htons(ETH_P_ALL);
+        address.sll_ifindex = ifindex;
+        if(bind(fd_, reinterpret_cast<struct sockaddr *>(&address), sizeof(address)) != 0) return error("cannot bind to network interface '" + interface + "'");
+
+        if(promiscuous) {
+            struct packet_mreq membership;
+            memset(&membership, 0, sizeof(membership));
+            membership.mr_ifindex = ifindex;
+            membership.mr_type = PACKET_MR_PROMISC;
+            if(setsockopt(fd_, SOL_PACKET, PACKET_ADD_MEMBERSHIP, &membership, sizeof(membership)) != 0) return error("cannot enable promiscuous mode");
+        }
+
+        return std::string();
+    }
+
+    // Adds the socket to fanout group 'group' of its interface.  If 'group'
+    // is negative, a new group with a unique identifier is created, and its
+    // identifier is stored in 'group' for the other sockets to join.  'mode'
+    // is one of the PACKET_FANOUT_* modes, and may include PACKET_FANOUT_FLAG_*
+    // flags in its upper bits.  For PACKET_FANOUT_EBPF, 'program' is the
+    // file descriptor of the eBPF program that selects a socket for each
+    // packet, otherwise it is ignored.  Returns an empty string on success,
+    // or an error message.
+    std::string joinFanout(int &group, int mode, int program) {
+        uint32_t value = static_cast<uint32_t>(mode) << 16;
+        if(group >= 0) {
+            value |= group & 0xffff;
+        } else {
+#ifdef PACKET_FANOUT_FLAG_UNIQUEID
+            value |= static_cast<uint32_t>(PACKET_FANOUT_FLAG_UNIQUEID) << 16;
+#else
+            value |= getpid() & 0xffff;
+#endif
+        }
+        if(setsockopt(fd_, SOL_PACKET, PACKET_FANOUT, &value, sizeof(value)) != 0) return error("cannot join fanout group");
+#ifdef PACKET_FANOUT_EBPF
+        if((mode & 0xff) == PACKET_FANOUT_EBPF && setsockopt(fd_, SOL_PACKET, PACKET_FANOUT_DATA, &program, sizeof(program)) != 0) return error("cannot attach fanout program");
+#endif
+        if(group < 0) {
+            socklen_t length = sizeof(value);
+            if(getsockopt(fd_, SOL_PACKET, PACKET_FANOUT, &value, &length) != 0) return error("cannot get fanout group");
+            group = value & 0xffff;
+        }
+        return std::string();
+    }
+
+    // Returns a file descriptor for an eBPF program pinned at 'path' in the
+    // BPF file system, for joinFanout(), or -1 and sets 'message'.
+    static int openPinnedProgram(const std::string &path, std::string &message) {
+#ifdef __NR_bpf
+        union bpf_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.pathname = reinterpret_cast<uintptr_t>(path.c_str());
+        const int program = syscall(__NR_bpf, BPF_OBJ_GET, &attr, sizeof(attr));
+        if(program < 0) message = "cannot open eBPF program '" + path + "', " + strerror(errno);
+        return program;
+#else
+        message = "eBPF programs are not supported";
+        return -1;
+#endif
+    }
+
+    void close() {
+        if(ring_) munmap(ring_, ringSize_);
+        if(fd_ >= 0) ::close(fd_);
+        fd_ = -1;
+        ring_ = NULL;
+        ringSize_ = 0;
+    }
+
+    int fd() const {
+        return fd_;
+    }
+
+    // Returns the next block of packets, waiting up to 'timeout'
+    // milliseconds for the kernel to hand it over, or NULL if it did not.
+    struct tpacket_block_desc *nextBlock(int timeout) {
+        struct tpacket_block_desc *block = reinterpret_cast<struct tpacket_block_desc *>(ring_ + currentBlock_ * blockSize_);
+        if(blockReady(block)) return block;
+
+        struct pollfd descriptor;
+        descriptor.fd = fd_;
+        descriptor.events = POLLIN | POLLERR;
+        descriptor.revents = 0;
+        poll(&descriptor, 1, timeout);
+        return blockReady(block) ? block : NULL;
+    }
+
+    // Gives a block returned by nextBlock() back to the kernel.
+    void releaseBlock(struct tpacket_block_desc *block) {
+        __atomic_store_n(&block->hdr.bh1.block_status, TP_STATUS_KERNEL, __ATOMIC_RELEASE);
+        currentBlock_ = (currentBlock_ + 1) % blockCount_;
+    }
+
+    // Return the first packet in a block, and the packet after 'packet', or
+    // NULL at the end of the block.
+    static struct tpacket3_hdr *firstPacket(struct tpacket_block_desc *block) {
+        if(block->hdr.bh1.num_pkts == 0) return NULL;
+        return reinterpret_cast<struct tpacket3_hdr *>(reinterpret_cast<uint8_t *>(block) + block->hdr.bh1.offset_to_first_pkt);
+    }
+
+    static struct tpacket3_hdr *nextPacket(struct tpacket3_hdr *packet) {
+        if(packet->tp_next_offset == 0) return NULL;
+        return reinterpret_cast<struct tpacket3_hdr *>(reinterpret_cast<uint8_t *>(packet) + packet->tp_next_offset);
+    }
+
+    // Returns a pointer to the packet data, with its VLAN tag put back, if
+    // the kernel stripped one.  tp_snaplen and tp_len are updated to match.
+    static uint8_t *packetData(struct tpacket3_hdr *packet) {
+        uint8_t *data = reinterpret_cast<uint8_t *>(packet) + packet->tp_mac;
+        if(!(packet->tp_status & TP_STATUS_VLAN_VALID) || packet->tp_snaplen < 2 * ETH_ALEN ||
+           packet->tp_mac < sizeof(struct tpacket3_hdr) + VLAN_TAG_LENGTH) {
+            return data;
+        }
+
+        uint16_t tpid = ETH_P_8021Q;
+#ifdef TP_STATUS_VLAN_TPID_VALID
+        if(packet->tp_status & TP_STATUS_VLAN_TPID_VALID) tpid = packet->hv1.tp_vlan_tpid;
+#endif
+        memmove(data - VLAN_TAG_LENGTH, data, 2 * ETH_ALEN);
+        data -= VLAN_TAG_LENGTH;
+        const uint16_t tag[2] = { htons(tpid), htons(packet->hv1.tp_vlan_tci) };
+        memcpy(data + 2 * ETH_ALEN, tag, sizeof(tag));
+
+        packet->tp_mac -= VLAN_TAG_LENGTH;
+        packet->tp_snaplen += VLAN_TAG_LENGTH;
+        packet->tp_len += VLAN_TAG_LENGTH;
+        packet->tp_status &= ~TP_STATUS_VLAN_VALID;
+        return data;
+    }
+
+    // Gets the number of packets received, including those dropped, and
+    // the number of packets dropped because the ring was full, since the
+    // socket was opened.
+    bool statistics(uint64_t &packets, uint64_t &drops) {
+        struct tpacket_stats_v3 stats;
+        socklen_t length = sizeof(stats);
+        if(fd_ < 0 || getsockopt(fd_, SOL_PACKET, PACKET_STATISTICS, &stats, &length) != 0) return false;
+
+        // the kernel resets its counters on each call
+        packets_ += stats.tp_packets;
+        drops_ += stats.tp_drops;
+        packets = packets_;
+        drops = drops_;
+        return true;
+    }
+
+private:
+    PacketSocketRing(const PacketSocketRing &);
+    PacketSocketRing &operator=(const PacketSocketRing &);
+
+    static bool blockReady(struct tpacket_block_desc *block) {
+        return (__atomic_load_n(&block->hdr.bh1.block_status, __ATOMIC_ACQUIRE) & TP_STATUS_USER) != 0;
+    }
+
+    std::string error(const std::string &what) {
+        std::string message = what + ", " + strerror(errno);
+        close();
+        return message;
+    }
+
+    int fd_;
+    uint8_t *ring_;
+    size_t ringSize_;
+    size_t blockSize_;
+    size_t blockCount_;
+    size_t currentBlock_;
+    uint64_t packets_;
+    uint64_t drops_;
+};
+
+} } } }
+
+#endif
@@ -0,0 +1,147 @@
+/*********************************************************************
+ * Copyright (C) 2026 International Business Machines Corporation
+ * All Rights Reserved
+ ********************************************************************/
+
+#ifndef RCU_POINTER_H_
+#define RCU_POINTER_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <sched.h>
+#include <atomic>
+
+namespace com { namespace ibm { namespace streamsx { namespace network {
+
+// This class publishes a read-mostly object (e.g. a filter list) to any
+// number of reader threads without locks on the read side, in the style
+// of read-copy-update (RCU).
+//
+// Readers wrap their accesses in a ReadGuard, which registers them in the
+// current epoch with one atomic increment on a per-thread counter stripe,
+// and then use the object through the guard.  A reader never blocks and
+// never waits for a writer.
+//
+// The writer builds a new object off to the side and hands it to
+// publish(), which swaps it in, advances the epoch, and waits until all
+// readers that registered in the previous epoch (and so might still be
+// using the old object) have left.  It then returns the old object to the
+// caller, who owns it again and can delete it or, as the operators in this
+// toolkit do, clear it and reuse it as the next write buffer.
+//
+// Only one thread may call publish() at a time, and a reader must not hold
+// a ReadGuard while waiting on anything the writer does.
+template<typename T>
+class RCUPointer {
+public:
+    static const size_t STRIPE_COUNT = 32;
+
+    class ReadGuard {
+    public:
+        explicit ReadGuard(const RCUPointer &rcu): counter_(rcu.enter()), value_(rcu.current_.load(std::memory_order_seq_cst)) {}
+
+        ~ReadGuard() {
+            counter_->fetch_sub(1, std::memory_order_release);
+        }
+
+        T *get() const { return value_; }
+        T *operator->() const { return value_; }
+        T &operator*() const { return *value_; }
+
+    private:
+        ReadGuard(const ReadGuard &);
+        ReadGuard &operator=(const ReadGuard &);
+
+        std::atomic<size_t> *counter_;
+        T *value_;
+    };
+
+    explicit RCUPointer(T *initial = NULL): current_(initial), epoch_(0) {
+        for(size_t i = 0; i < 2; ++i) {
+            for(size_t s = 0; s < STRIPE_COUNT; ++s) {
+                readers_[i][s].count.store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Deletes the currently published object.  No readers may be active.
+    ~RCUPointer() {
+        delete current_.load(std::memory_order_relaxed);
+    }
+
+    // Returns the currently published object without registering as a
+    // reader.  Only safe on the writer's thread, since only the writer
+    // can retire the object.
+    T *unsafeGet() const {
+        return current_.load(std::memory_order_acquire);
+    }
+
+    // Publishes 'value' to readers and returns the previously published
+    // object once no reader can still be using it.
+    T *publish(T *value) {
+        T *old = current_.exchange(value, std::memory_order_seq_cst);
+        synchronize();
+        return old;
+    }
+
+    // Waits until every reader that was active when this was called has
+    // finished.
+    void synchronize() {
+        size_t oldParity = epoch_.fetch_add(1, std::memory_order_seq_cst) & 1;
+        while(readerCount(oldParity) != 0) {
+            sched_yield();
+        }
+    }
+
+private:
+    RCUPointer(const RCUPointer &);
+    RCUPointer &operator=(const RCUPointer &);
+
+    struct stripe {
+        std::atomic<size_t> count;
+    } __attribute__((aligned(64)));
+
+    // Assigns each thread its own counter stripe, so readers on different
+    // threads do not contend for the same cache line.
+    static size_t stripeIndex() {
+        static std::atomic<size_t> nextStripe(0);
+        static __thread size_t threadStripe = STRIPE_COUNT;
+        if(__builtin_expect(threadStripe == STRIPE_COUNT, 0)) {
+            threadStripe = nextStripe.fetch_add(1, std::memory_order_relaxed) % STRIPE_COUNT;
+        }
+        return threadStripe;
+    }
+
+    // Registers a reader in the current epoch and returns the counter to
+    // decrement when it leaves.  If the epoch advances while registering,
+    // the writer may already have stopped waiting on the old epoch, so
+    // the reader must move to the new one.
+    std::atomic<size_t> *enter() const {
+        size_t s = stripeIndex();
+        while(true) {
+            size_t epoch = epoch_.load(std::memory_order_seq_cst);
+            std::atomic<size_t> *counter = &readers_[epoch & 1][s].count;
+            counter->fetch_add(1, std::memory_order_seq_cst);
+            if(__builtin_expect(epoch_.load(std::memory_order_seq_cst) == epoch, 1)) {
+                return counter;
+            }
+            counter->fetch_sub(1, std::memory_order_release);
+        }
+    }
+
+    size_t readerCount(size_t parity) const {
+        size_t count = 0;
+        for(size_t s = 0; s < STRIPE_COUNT; ++s) {
+            count += readers_[parity][s].count.load(std::memory_order_acquire);
+        }
+        return count;
+    }
+
+    std::atomic<T *> current_ __attribute__((aligned(64)));
+    std::atomic<size_t> epoch_ __attribute__((aligned(64)));
+    mutable stripe readers_[2][STRIPE_COUNT];
+};
+
+} } } }
+
+#endif
@@ -0,0 +1,136 @@
+/*********************************************************************
+ * Copyright (C) 2026 International Business Machines Corporation
+ * All Rights Reserved
+ ********************************************************************/
+
+#ifndef SET_ASSOCIATIVE_CACHE_H_
+#define SET_ASSOCIATIVE_CACHE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+namespace com { namespace ibm { namespace streamsx { namespace network {
+
+// This class caches values by key in a fixed amount of memory, e.g. the
+// results of searching a large table for recently seen addresses.
+//
+// The cache is divided into sets of WAYS entries, and a key can only be
+// stored in the set selected by its hash, so a lookup compares at most
+// WAYS keys.  When a set is full, the entry to replace is chosen with the
+// CLOCK algorithm: each entry has a reference bit which is set when it is
+// found, and a hand sweeps the set clearing reference bits until it finds
+// an entry that has not been referenced since the last sweep.  Frequently
+// used keys therefore stay in the cache even when they are outnumbered by
+// keys seen only once.
+//
+// The Hash functor must return a well mixed uint32_t for a key.  The cache
+// keeps hit and miss counts for metrics.  It is not thread safe.
+template<typename Key, typename Value, typename Hash, size_t WAYS = 4>
+class SetAssociativeCache {
+    static_assert(WAYS >= 1 && WAYS <= 8, "the way bits of a set must fit in a byte");
+
+public:
+    // Creates a cache for about 'capacity' entries, rounded up to a power
+    // of two sets.  A capacity of zero disables the cache.
+    explicit SetAssociativeCache(size_t capacity = 0) {
+        resize(capacity);
+    }
+
+    // Changes the capacity, dropping all entries.
+    void resize(size_t capacity) {
+        size_t sets = 0;
+        if(capacity > 0) {
+            sets = 1;
+            while(sets * WAYS < capacity) sets *= 2;
+        }
+        sets_.assign(sets, set());
+        mask_ = sets ? sets - 1 : 0;
+        hits_ = 0;
+        misses_ = 0;
+    }
+
+    // Drops all entries, e.g. when the table the values came from changes.
+    // The hit and miss counts are kept.
+    void clear() {
+        for(size_t s = 0; s < sets_.size(); ++s) {
+            sets_[s].used = 0;
+            sets_[s].referenced = 0;
+            sets_[s].hand = 0;
+        }
+    }
+
+    // Returns the number of entries the cache can hold.
+    size_t capacity() const {
+        return sets_.size() * WAYS;
+    }
+
+    // Looks up a key.  Returns true and stores its value in 'value' if the
+    // key is in the cache.
+    bool find(const Key &key, Value &value) {
+        if(sets_.empty()) { ++misses_; return false; }
+
+        set &s = sets_[Hash()(key) & mask_];
+        for(size_t w = 0; w < WAYS; ++w) {
+            if((s.used & bit(w)) && s.key[w] == key) {
+                s.referenced |= bit(w);
+                value = s.value[w];
+                ++hits_;
+                return true;
+            }
+        }
+        ++misses_;
+        return false;
+    }
+
+    // Stores a key and its value, replacing an entry of its set if the set
+    // is full.  The key must not be in the cache already.
+    void insert(const Key &key, const Value &value) {
+        if(sets_.empty()) return;
+
+        set &s = sets_[Hash()(key) & mask_];
+        size_t w;
+        if(s.used != FULL) {
+            for(w = 0; s.used & bit(w); ++w) {}
+        } else {
+            while(s.referenced & bit(s.hand)) {
+                s.referenced &= ~bit(s.hand);
+                s.hand = (s.hand + 1) % WAYS;
+            }
+            w = s.hand;
+            s.hand = (s.hand + 1) % WAYS;
+        }
+        s.key[w] = key;
+        s.value[w] = value;
+        s.used |= bit(w);
+        s.referenced &= ~bit(w);
+    }
+
+    uint64_t hits() const { return hits_; }
+    uint64_t misses() const { return misses_; }
+
+private:
+    enum { FULL = (1 << WAYS) - 1 };
+
+    static uint8_t bit(size_t way) {
+        return static_cast<uint8_t>(1 << way);
+    }
+
+    struct set {
+        set(): key(), value(), used(0), referenced(0), hand(0) {}
+        Key key[WAYS];
+        Value value[WAYS];
+        uint8_t used;           // one bit per way
+        uint8_t referenced;     // one bit per way
+        uint8_t hand;
+    };
+
+    std::vector<set> sets_;
+    size_t mask_;
+    uint64_t hits_;
+    uint64_t misses_;
+};
+
+} } } }
+
+#endif
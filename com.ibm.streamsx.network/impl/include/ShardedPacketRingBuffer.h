@@ -0,0 +1,223 @@
+/*********************************************************************
+ * Copyright (C) 2026 International Business Machines Corporation
+ * All Rights Reserved
+ ********************************************************************/
+
+#ifndef SHARDED_PACKETRING_BUFFER_H_
+#define SHARDED_PACKETRING_BUFFER_H_
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <new>
+#include <string>
+#include <arpa/inet.h>
+#include <sys/uio.h>
+
+#include "PacketRingBuffer.h"
+
+// This class fans packets out from one producer to several consumers, each of
+// which takes packets from its own shard, a single-producer/single-consumer
+// PacketRingBuffer.  The producer chooses a shard for each packet by hashing
+// its flow, so that the packets of a flow are always taken by the same
+// consumer, in the order they were produced:
+//
+//     ShardedPacketRingBuffer ring;
+//     ring.open(consumers, entrySize, entryCount, numaNode);
+//
+//     // producer thread
+//     ring.produceMulti(packets, count);
+//
+//     // consumer thread 'i'
+//     PacketRingBuffer& shard = ring.shard(i);
+//     count = shard.peek(packets, max); ... shard.release();
+//
+// The flow hash is symmetric, so that both directions of a connection go to
+// the same shard.  It covers the IP addresses and, for TCP and UDP, the ports,
+// except in IP fragments, which are hashed by their addresses alone so that
+// all the fragments of a datagram go to the same shard.  Other packets are
+// hashed by their ethernet addresses.
+class ShardedPacketRingBuffer {
+public:
+    ShardedPacketRingBuffer(): shards(NULL), shard_count(0) {}
+
+    ~ShardedPacketRingBuffer() {
+        for(size_t i = 0; i < shard_count; ++i) shards[i].~PacketRingBuffer();
+        free(shards);
+    }
+
+    // Allocates 'count' shards, each a ring of 'entryCount' entries of
+    // 'entrySize' bytes, on NUMA node 'numaNode', as PacketRingBuffer::open() does.
+    // Returns an empty string if successful, or a description of the error otherwise.
+    std::string open(size_t count, size_t entrySize = PacketRingBuffer::ENTRY_SIZE, size_t entryCount = PacketRingBuffer::ENTRY_COUNT, int numaNode = -1) {
+        if(shards) return "ring buffer is already allocated";
+        if(count < 1 || count > MAX_SHARDS) return "ring buffer shard count " + std::to_string(count) + " is not from 1 to " + std::to_string((size_t)MAX_SHARDS);
+
+        // The shards' heads and tails are aligned to cache lines, which new[] does not do.
+        void *memory = NULL;
+        if(posix_memalign(&memory, 64, count * sizeof(PacketRingBuffer)) != 0) return "could not allocate ring buffer shards";
+        shards = (PacketRingBuffer*)memory;
+        for(shard_count = 0; shard_count < count; ++shard_count) new (&shards[shard_count]) PacketRingBuffer();
+
+        for(size_t i = 0; i < count; ++i) {
+            const std::string error = shards[i].open(entrySize, entryCount, numaNode);
+            if(!error.empty()) return error;
+        }
+        return "";
+    }
+
+    size_t shardCount() const { return shard_count; }
+
+    // Sets the overflow policy and idle polling of every shard, as PacketRingBuffer does.
+    void setOverflowPolicy(PacketRingBuffer::overflow_policy_t policy, uint32_t sampling = 1, uint64_t timeout = 0) {
+        for(size_t i = 0; i < shard_count; ++i) shards[i].setOverflowPolicy(policy, sampling, timeout);
+    }
+
+    void setIdlePolls(size_t polls) {
+        for(size_t i = 0; i < shard_count; ++i) shards[i].setIdlePolls(polls);
+    }
+
+    // The count of packets discarded from all shards under the DROP_OLDEST policy.
+    uint64_t flushedCount() const {
+        uint64_t count = 0;
+        for(size_t i = 0; i < shard_count; ++i) count += shards[i].flushedCount();
+        return count;
+    }
+
+    PacketRingBuffer& shard(size_t index) { return shards[index]; }
+
+    // Returns the shard a packet belongs in.
+    PacketRingBuffer& shardOf(const void *packet, size_t len) {
+        if(shard_count == 1) return shards[0];
+        return shards[((uint64_t)flowHash((const uint8_t*)packet, len) * shard_count) >> 32];
+    }
+
+    // Just gets a live estimate of the number of items in the fullest shard.
+    size_t size() {
+        size_t largest = 0;
+        for(size_t i = 0; i < shard_count; ++i) {
+            const size_t size = shards[i].size();
+            if(size > largest) largest = size;
+        }
+        return largest;
+    }
+
+    // Produces one packet into its shard, if there is room for it.
+    // Returns true if the packet could be added, false otherwise.
+    bool produce(void *data, uint32_t len) {
+        return shardOf(data, len).produce(data, len);
+    }
+
+    // Produces multiple packets into their shards, to the extent there is room.
+    // Returns the count of produced packets.  Unlike PacketRingBuffer::produceMulti(),
+    // the packets that did not fit are not necessarily the last ones in the vector,
+    // so they cannot be produced again later without reordering their flows; the
+    // caller should drop them.  Each shard's head is updated once for each group of
+    // up to GROUP_SIZE packets that belong in it.
+    size_t produceMulti(const struct iovec *vector, size_t count) {
+        if(shard_count == 1) return shards[0].produceMulti(vector, count);
+
+        size_t produced = 0;
+        for(size_t start = 0; start < count; start += GROUP_SIZE) {
+            const size_t end = start + GROUP_SIZE < count ? start + GROUP_SIZE : count;
+
+            uint8_t shard_of[GROUP_SIZE];
+            size_t shard_used[MAX_SHARDS] = { 0 };
+            for(size_t i = start; i < end; ++i) {
+                const size_t index = ((uint64_t)flowHash((const uint8_t*)vector[i].iov_base, vector[i].iov_len) * shard_count) >> 32;
+                shard_of[i - start] = index;
+                ++shard_used[index];
+            }
+
+            // Gather each shard's packets, in order, and produce them together.
+            for(size_t index = 0; index < shard_count; ++index) {
+                if(!shard_used[index]) continue;
+                size_t gathered = 0;
+                for(size_t i = start; i < end; ++i) {
+                    if(shard_of[i - start] == index) group[gathered++] = vector[i];
+                }
+                produced += shards[index].produceMulti(group, gathered);
+            }
+        }
+        return produced;
+    }
+
+    // Computes the symmetric flow hash of the ethernet frame in 'packet'.
+    static uint32_t flowHash(const uint8_t *packet, size_t len) {
+        if(len < ETHER_HEADER_SIZE) return 0;
+
+        size_t offset = 12;
+        uint16_t type = load16(packet + offset);
+        while((type == 0x8100 || type == 0x88A8) && len >= offset + 6) {
+            offset += 4;
+            type = load16(packet + offset);
+        }
+        offset += 2;
+
+        uint64_t hash = 0;
+        uint8_t protocol = 0;
+        bool fragment = false;
+        if(type == 0x0800 && len >= offset + 20) {
+            const uint8_t *ip = packet + offset;
+            const size_t headerLength = (ip[0] & 0x0F) * 4;
+            protocol = ip[9];
+            fragment = (load16(ip + 6) & 0x3FFF) != 0;
+            hash = (uint64_t)load32(ip + 12) + load32(ip + 16);
+            offset += headerLength;
+        } else if(type == 0x86DD && len >= offset + 40) {
+            const uint8_t *ip = packet + offset;
+            protocol = ip[6];
+            fragment = protocol == 44;
+            for(size_t i = 8; i < 40; i += 4) hash += load32(ip + i);
+            offset += 40;
+        } else {
+            // Not IP.  Hash the ethernet addresses.
+            hash = (uint64_t)load32(packet) + load32(packet + 6) + load16(packet + 4) + load16(packet + 10);
+            return mix(hash);
+        }
+
+        if((protocol == 6 || protocol == 17) && !fragment && len >= offset + 4) {
+            hash += (uint64_t)load16(packet + offset) + load16(packet + offset + 2);
+        }
+        return mix(hash + protocol);
+    }
+
+private:
+    enum {
+        MAX_SHARDS = 64,
+        GROUP_SIZE = 64,
+        ETHER_HEADER_SIZE = 14
+    };
+
+    static uint16_t load16(const uint8_t *p) {
+        uint16_t value;
+        memcpy(&value, p, sizeof(value));
+        return ntohs(value);
+    }
+
+    static uint32_t load32(const uint8_t *p) {
+        uint32_t value;
+        memcpy(&value, p, sizeof(value));
+        return ntohl(value);
+    }
+
+    // Spreads the bits of a sum of addresses and ports across the hash.
+    static uint32_t mix(uint64_t hash) {
+        hash ^= hash >> 33;
+        hash *= 0xff51afd7ed558ccdull;
+        hash ^= hash >> 33;
+        hash *= 0xc4ceb9fe1a85ec53ull;
+        hash ^= hash >> 33;
+        return (uint32_t)hash;
+    }
+
+    PacketRingBuffer *shards;
+    size_t shard_count;
+    struct iovec group[GROUP_SIZE];
+
+    // Copying a ring buffer is not supported.
+    ShardedPacketRingBuffer(const ShardedPacketRingBuffer&);
+    ShardedPacketRingBuffer& operator=(const ShardedPacketRingBuffer&);
+};
+
+#endif
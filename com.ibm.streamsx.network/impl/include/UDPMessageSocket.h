@@ -0,0 +1,249 @@
+/*********************************************************************
+ * Copyright (C) 2026 International Business Machines Corporation
+ * All Rights Reserved
+ ********************************************************************/
+
+#ifndef UDP_MESSAGE_SOCKET_H_
+#define UDP_MESSAGE_SOCKET_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <time.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <string>
+#include <vector>
+
+#ifndef SO_RXQ_OVFL
+#define SO_RXQ_OVFL 40
+#endif
+
+namespace com { namespace ibm { namespace streamsx { namespace network {
+
+// This class receives UDP messages, such as Netflow, IPFIX or DNS messages,
+// in batches with recvmmsg(), so that one system call returns as many
+// messages as are waiting, up to the batch size:
+//
+//     size_t count = socket.receive(timeout);
+//     for (size_t i = 0; i < count; i++) {
+//       const UDPMessageSocket::Message& message = socket.message(i);
+//       ... socket.data(i), message.length, message.source ...
+//     }
+//
+// Each message keeps the address and port it was sent from, the local
+// address it was sent to, and the time the kernel received it.
+//
+// The socket is opened with SO_REUSEPORT, so several sockets, in one or
+// more threads or processes, can be bound to the same port.  The kernel
+// then distributes messages across them by a hash of their addresses and
+// ports, so all messages from one exporter arrive at the same socket, in
+// order.
+//
+// One thread may receive from a socket, and another may call statistics().
+class UDPMessageSocket {
+public:
+    struct Message {
+        struct sockaddr_storage source;   // address and port the message was sent from
+        struct sockaddr_storage destination; // local address and port the message was sent to
+        struct timespec timestamp;        // time the kernel received the message
+        uint32_t length;                  // length of the message data, at most 'maximumLength'
+        uint32_t originalLength;          // length of the message as sent
+    };
+
+    UDPMessageSocket(): fd_(-1), maximumLength_(0), port_(0), count_(0), received_(0), dropped_(0) {}
+
+    ~UDPMessageSocket() {
+        close();
+    }
+
+    // Opens a socket bound to 'address' and 'port', which receives up to
+    // 'batchSize' messages of up to 'maximumLength' bytes at a time.  An
+    // empty address receives messages sent to any local IPv4 or IPv6
+    // address.  If 'bufferSize' is greater than zero, it sets the size of
+    // the socket's receive buffer.  Returns an empty string on success, or
+    // an error message.
+    std::string open(const std::string &address, uint16_t port, uint32_t batchSize, uint32_t maximumLength, int bufferSize) {
+        close();
+
+        struct sockaddr_storage local;
+        memset(&local, 0, sizeof(local));
+        socklen_t localLength;
+        struct sockaddr_in *local4 = reinterpret_cast<struct sockaddr_in *>(&local);
+        struct sockaddr_in6 *local6 = reinterpret_cast<struct sockaddr_in6 *>(&local);
+        if(!address.empty() && inet_pton(AF_INET, address.c_str(), &local4->sin_addr) == 1) {
+            local4->sin_family = AF_INET;
+            local4->sin_port = htons(port);
+            localLength = sizeof(*local4);
+        } else if(address.empty() || inet_pton(AF_INET6, address.c_str(), &local6->sin6_addr) == 1) {
+            local6->sin6_family = AF_INET6;
+            local6->sin6_port = htons(port);
+            localLength = sizeof(*local6);
+        } else {
+            return "cannot parse local address '" + address + "'";
+        }
+
+        fd_ = socket(local.ss_family, SOCK_DGRAM, IPPROTO_UDP);
+        if(fd_ < 0) return error("cannot create UDP socket");
+
+        int on = 1;
+        int off = 0;
+        if(setsockopt(fd_, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) != 0) return error("cannot share UDP port");
+        if(setsockopt(fd_, SOL_SOCKET, SO_TIMESTAMPNS, &on, sizeof(on)) != 0) return error("cannot enable receive timestamps");
+        if(setsockopt(fd_, SOL_SOCKET, SO_RXQ_OVFL, &on, sizeof(on)) != 0) return error("cannot enable drop counter");
+        if(setsockopt(fd_, IPPROTO_IP, IP_PKTINFO, &on, sizeof(on)) != 0 && local.ss_family == AF_INET) return error("cannot enable destination addresses");
+        if(local.ss_family == AF_INET6) {
+            if(address.empty() && setsockopt(fd_, IPPROTO_IPV6, IPV6_V6ONLY, &off, sizeof(off)) != 0) return error("cannot enable IPv4 messages");
+            if(setsockopt(fd_, IPPROTO_IPV6, IPV6_RECVPKTINFO, &on, sizeof(on)) != 0) return error("cannot enable destination addresses");
+        }
+        if(bufferSize > 0 && setsockopt(fd_, SOL_SOCKET, SO_RCVBUF, &bufferSize, sizeof(bufferSize)) != 0) return error("cannot set receive buffer size");
+
+        if(bind(fd_, reinterpret_cast<struct sockaddr *>(&local), localLength) != 0) return error("cannot bind to UDP port");
+
+        // All of the buffers for a batch are allocated once, and recvmmsg()
+        // fills them in place.
+        maximumLength_ = maximumLength;
+        port_ = port;
+        buffers_.assign((size_t)batchSize * maximumLength, 0);
+        controls_.assign((size_t)batchSize * CONTROL_LENGTH, 0);
+        iovecs_.resize(batchSize);
+        headers_.resize(batchSize);
+        messages_.resize(batchSize);
+        for(uint32_t i = 0; i < batchSize; i++) {
+            iovecs_[i].iov_base = &buffers_[(size_t)i * maximumLength];
+            iovecs_[i].iov_len = maximumLength;
+            memset(&headers_[i], 0, sizeof(headers_[i]));
+            headers_[i].msg_hdr.msg_name = &messages_[i].source;
+            headers_[i].msg_hdr.msg_iov = &iovecs_[i];
+            headers_[i].msg_hdr.msg_iovlen = 1;
+            headers_[i].msg_hdr.msg_control = &controls_[(size_t)i * CONTROL_LENGTH];
+        }
+        count_ = 0;
+
+        return std::string();
+    }
+
+    void close() {
+        if(fd_ >= 0) ::close(fd_);
+        fd_ = -1;
+        count_ = 0;
+    }
+
+    int fd() const {
+        return fd_;
+    }
+
+    // Receives the messages waiting at the socket, up to the batch size,
+    // waiting up to 'timeout' milliseconds for the first one.  Returns the
+    // number of messages received, which stay valid until the next call.
+    size_t receive(int timeout) {
+        count_ = 0;
+
+        struct pollfd descriptor = { fd_, POLLIN, 0 };
+        if(poll(&descriptor, 1, timeout) <= 0) return 0;
+
+        for(size_t i = 0; i < headers_.size(); i++) {
+            headers_[i].msg_hdr.msg_namelen = sizeof(messages_[i].source);
+            headers_[i].msg_hdr.msg_controllen = CONTROL_LENGTH;
+            headers_[i].msg_hdr.msg_flags = 0;
+        }
+
+        // With MSG_TRUNC, the kernel reports the original length of messages
+        // that were longer than their buffers.
+        const int count = recvmmsg(fd_, &headers_[0], headers_.size(), MSG_DONTWAIT | MSG_TRUNC, NULL);
+        if(count <= 0) return 0;
+
+        for(int i = 0; i < count; i++) {
+            Message &message = messages_[i];
+            message.originalLength = headers_[i].msg_len;
+            message.length = headers_[i].msg_len < maximumLength_ ? headers_[i].msg_len : maximumLength_;
+            memset(&message.destination, 0, sizeof(message.destination));
+            message.timestamp.tv_sec = 0;
+            message.timestamp.tv_nsec = 0;
+            readControl(headers_[i].msg_hdr, message);
+        }
+        count_ = count;
+        __atomic_add_fetch(&received_, (uint64_t)count, __ATOMIC_RELAXED);
+        return count_;
+    }
+
+    size_t count() const {
+        return count_;
+    }
+
+    const Message &message(size_t index) const {
+        return messages_[index];
+    }
+
+    const uint8_t *data(size_t index) const {
+        return &buffers_[index * maximumLength_];
+    }
+
+    // Returns the number of messages received and the number of messages
+    // the kernel dropped because the socket's receive buffer was full, as of
+    // the last batch received.
+    void statistics(uint64_t &received, uint64_t &dropped) const {
+        received = __atomic_load_n(&received_, __ATOMIC_RELAXED);
+        dropped = __atomic_load_n(&dropped_, __ATOMIC_RELAXED);
+    }
+
+private:
+    enum { CONTROL_LENGTH = 256 };
+
+    UDPMessageSocket(const UDPMessageSocket &);
+    UDPMessageSocket &operator=(const UDPMessageSocket &);
+
+    void readControl(struct msghdr &header, Message &message) {
+        for(struct cmsghdr *control = CMSG_FIRSTHDR(&header); control; control = CMSG_NXTHDR(&header, control)) {
+            if(control->cmsg_level == SOL_SOCKET && control->cmsg_type == SO_TIMESTAMPNS) {
+                memcpy(&message.timestamp, CMSG_DATA(control), sizeof(message.timestamp));
+            } else if(control->cmsg_level == SOL_SOCKET && control->cmsg_type == SO_RXQ_OVFL) {
+                // the kernel's count of messages dropped at this socket since it was opened
+                uint32_t dropped;
+                memcpy(&dropped, CMSG_DATA(control), sizeof(dropped));
+                __atomic_store_n(&dropped_, (uint64_t)dropped, __ATOMIC_RELAXED);
+            } else if(control->cmsg_level == IPPROTO_IP && control->cmsg_type == IP_PKTINFO) {
+                struct in_pktinfo info;
+                memcpy(&info, CMSG_DATA(control), sizeof(info));
+                struct sockaddr_in *destination = reinterpret_cast<struct sockaddr_in *>(&message.destination);
+                destination->sin_family = AF_INET;
+                destination->sin_port = htons(port_);
+                destination->sin_addr = info.ipi_addr;
+            } else if(control->cmsg_level == IPPROTO_IPV6 && control->cmsg_type == IPV6_PKTINFO) {
+                struct in6_pktinfo info;
+                memcpy(&info, CMSG_DATA(control), sizeof(info));
+                struct sockaddr_in6 *destination = reinterpret_cast<struct sockaddr_in6 *>(&message.destination);
+                destination->sin6_family = AF_INET6;
+                destination->sin6_port = htons(port_);
+                destination->sin6_addr = info.ipi6_addr;
+            }
+        }
+    }
+
+    std::string error(const std::string &what) {
+        std::string message = what + ", " + strerror(errno);
+        close();
+        return message;
+    }
+
+    int fd_;
+    uint32_t maximumLength_;
+    uint16_t port_;
+    size_t count_;
+    uint64_t received_;
+    uint64_t dropped_;
+    std::vector<uint8_t> buffers_;
+    std::vector<uint8_t> controls_;
+    std::vector<struct iovec> iovecs_;
+    std::vector<struct mmsghdr> headers_;
+    std::vector<Message> messages_;
+};
+
+} } } }
+
+#endif
@@ -0,0 +1,493 @@
+/*********************************************************************
+ * Copyright (C) 2026 International Business Machines Corporation
+ * All Rights Reserved
+ ********************************************************************/
+
+#ifndef XDP_SOCKET_H_
+#define XDP_SOCKET_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <net/if.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/resource.h>
+#include <sys/uio.h>
+#include <linux/if_link.h>
+#include <linux/if_xdp.h>
+#include <linux/bpf.h>
+#include <string>
+#include <vector>
+
+#ifndef AF_XDP
+#define AF_XDP 44
+#endif
+#ifndef SOL_XDP
+#define SOL_XDP 283
+#endif
+
+namespace com { namespace ibm { namespace streamsx { namespace network {
+
+// This class receives packets from one queue of a network interface through
+// a Linux AF_XDP socket.
+//
+// The packets are received into a 'UMEM', an area of memory shared with the
+// kernel, divided into frames of equal size.  The socket hands frames to the
+// kernel on its 'fill' ring, the kernel (or, in zero copy mode, the network
+// adapter) writes packets into them, and hands them back on the 'receive'
+// ring.  Both rings are mapped into memory, so a batch of packets is
+// received without a system call, as long as packets keep arriving:
+//
+//     size_t count = socket.receive(visitor, 64);
+//     if (count == 0) socket.wait(timeout);
+//
+// where visitor(const struct iovec* packets, size_t count) is called once
+// for the whole batch.  The packets are valid only until it returns.
+//
+// Packets are passed to the socket by an XDP program attached to the
+// interface, which redirects them through an XSKMAP indexed by queue.  By
+// default, the first socket opened on an interface loads and attaches a
+// program that redirects all of the packets received by the interface, and
+// lets the kernel handle those for queues that have no socket.  Sockets
+// opened later on other queues of the interface, in this process or
+// another, find that program through its BPF link and add themselves to its
+// XSKMAP.  Each socket holds a reference to the link, so the program is
+// detached when the last of them is closed.  Alternatively, the path of a
+// pinned program and a pinned XSKMAP may be specified, e.g. to filter
+// packets before they are redirected.
+//
+// One thread may receive from a socket, and another may call statistics().
+class XDPSocket {
+public:
+    enum AttachMode { NATIVE, GENERIC };
+
+    XDPSocket(): fd_(-1), mapFd_(-1), programFd_(-1), linkFd_(-1), umem_(NULL), umemSize_(0), frameSize_(0),
+                 rxMap_(NULL), rxMapSize_(0), fillMap_(NULL), fillMapSize_(0), received_(0) {}
+
+    ~XDPSocket() {
+        close();
+    }
+
+    // Opens a socket on queue 'queue' of 'interface', with a UMEM of
+    // 'frameCount' frames of 'frameSize' bytes, and a receive ring of
+    // 'ringSize' descriptors.  All three must be powers of two, and the
+    // frame size must be 2048 or 4096.  'mode' selects native XDP, in the
+    // adapter driver, or generic XDP, in the kernel's network stack, which
+    // works with any interface, such as veth.  'zeroCopy' asks the adapter
+    // to write packets straight into the UMEM, which requires native mode
+    // and driver support.  If another socket has attached its program to the
+    // interface already, 'mode' is ignored and the socket shares that
+    // program.  If 'mapPath' is not empty, the socket is added to that
+    // pinned XSKMAP instead of the socket's own, and if
+    // 'programPath' is not empty, that pinned XDP program is attached to the
+    // interface instead of the socket's own.  Returns an empty string on
+    // success, or an error message.
+    std::string open(const std::string &interface, uint32_t queue, uint32_t frameCount, uint32_t frameSize, uint32_t ringSize,
+                     AttachMode mode, bool zeroCopy, const std::string &programPath, const std::string &mapPath) {
+        close();
+
+        const int ifindex = if_nametoindex(interface.c_str());
+        if(!ifindex) return "cannot find network interface '" + interface + "', " + strerror(errno);
+        if(!programPath.empty() && mapPath.empty()) return "a pinned XDP program needs the pinned XSKMAP it redirects packets through";
+
+        // kernels before 5.11 charge the UMEM and BPF objects to the locked memory limit
+        struct rlimit unlimited = { RLIM_INFINITY, RLIM_INFINITY };
+        setrlimit(RLIMIT_MEMLOCK, &unlimited);
+
+        fd_ = socket(AF_XDP, SOCK_RAW, 0);
+        if(fd_ < 0) return error("cannot create AF_XDP socket");
+
+        // register the UMEM, and set up its rings
+        umemSize_ = static_cast<size_t>(frameCount) * frameSize;
+        void *umem = mmap(NULL, umemSize_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if(umem == MAP_FAILED) {
+            umemSize_ = 0;
+            return error("cannot allocate UMEM");
+        }
+        umem_ = static_cast<uint8_t *>(umem);
+        frameSize_ = frameSize;
+
+        struct xdp_umem_reg registration;
+        memset(&registration, 0, sizeof(registration));
+        registration.addr = reinterpret_cast<uintptr_t>(umem_);
+        registration.len = umemSize_;
+        registration.chunk_size = frameSize;
+        registration.headroom = 0;
+        if(setsockopt(fd_, SOL_XDP, XDP_UMEM_REG, &registration, sizeof(registration)) != 0) return error("cannot register UMEM");
+
+        int fillSize = frameCount;
+        int completionSize = 1;
+        int rxSize = ringSize;
+        if(setsockopt(fd_, SOL_XDP, XDP_UMEM_FILL_RING, &fillSize, sizeof(fillSize)) != 0) return error("cannot create fill ring");
+        if(setsockopt(fd_, SOL_XDP, XDP_UMEM_COMPLETION_RING, &completionSize, sizeof(completionSize)) != 0) return error("cannot create completion ring");
+        if(setsockopt(fd_, SOL_XDP, XDP_RX_RING, &rxSize, sizeof(rxSize)) != 0) return error("cannot create receive ring");
+
+        struct xdp_mmap_offsets offsets;
+        socklen_t length = sizeof(offsets);
+        if(getsockopt(fd_, SOL_XDP, XDP_MMAP_OFFSETS, &offsets, &length) != 0) return error("cannot get ring offsets");
+
+        fillMapSize_ = offsets.fr.desc + fillSize * sizeof(uint64_t);
+        void *fillMap = mmap(NULL, fillMapSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, XDP_UMEM_PGOFF_FILL_RING);
+        if(fillMap == MAP_FAILED) {
+            fillMapSize_ = 0;
+            return error("cannot map fill ring");
+        }
+        fillMap_ = static_cast<uint8_t *>(fillMap);
+        fill_.attach(fillMap_, offsets.fr, fillSize);
+
+        rxMapSize_ = offsets.rx.desc + rxSize * sizeof(struct xdp_desc);
+        void *rxMap = mmap(NULL, rxMapSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, XDP_PGOFF_RX_RING);
+        if(rxMap == MAP_FAILED) {
+            rxMapSize_ = 0;
+            return error("cannot map receive ring");
+        }
+        rxMap_ = static_cast<uint8_t *>(rxMap);
+        rx_.attach(rxMap_, offsets.rx, rxSize);
+
+        // hand all of the frames to the kernel
+        for(uint32_t i = 0; i < frameCount; ++i) {
+            fill_[i] = static_cast<uint64_t>(i) * frameSize;
+        }
+        __atomic_store_n(fill_.producer, frameCount, __ATOMIC_RELEASE);
+
+        struct sockaddr_xdp address;
+        memset(&address, 0, sizeof(address));
+        address.sxdp_family = AF_XDP;
+        address.sxdp_ifindex = ifindex;
+        address.sxdp_queue_id = queue;
+        address.sxdp_flags = (zeroCopy ? XDP_ZEROCOPY : XDP_COPY) | XDP_USE_NEED_WAKEUP;
+        if(bind(fd_, reinterpret_cast<struct sockaddr *>(&address), sizeof(address)) != 0) return error("cannot bind to queue of network interface '" + interface + "'");
+
+        // add the socket to the pinned XSKMAP, and attach the pinned XDP program that redirects packets
+        // through it, unless only a map was given, in which case another socket or tool attaches the program
+        std::string message;
+        if(!mapPath.empty()) {
+            mapFd_ = openPinned(mapPath, message);
+            if(mapFd_ < 0) return error(message);
+            if(!insert(queue)) return error("cannot add socket to XSKMAP");
+            if(programPath.empty()) return std::string();
+
+            programFd_ = openPinned(programPath, message);
+            if(programFd_ < 0) return error(message);
+            linkFd_ = attach(programFd_, ifindex, mode);
+
+            // another socket on the same interface may have attached the program already
+            if(linkFd_ < 0 && errno != EBUSY) return error("cannot attach XDP program to network interface '" + interface + "'");
+            return std::string();
+        }
+
+        // otherwise, share the program and XSKMAP of a socket on another queue of the interface, or
+        // attach our own, looking again if another socket attached its program first
+        for(int attempt = 0; ; ++attempt) {
+            linkFd_ = findLink(ifindex, mapFd_);
+            if(linkFd_ >= 0) {
+                if(!insert(queue)) return error("cannot add socket to XSKMAP shared with other queues of network interface '" + interface + "'");
+                return std::string();
+            }
+
+            mapFd_ = createMap(queue < MAP_SIZE ? MAP_SIZE : queue + 1, message);
+            if(mapFd_ < 0) return error(message);
+            if(!insert(queue)) return error("cannot add socket to XSKMAP");
+            programFd_ = loadRedirectProgram(message);
+            if(programFd_ < 0) return error(message);
+            linkFd_ = attach(programFd_, ifindex, mode);
+            if(linkFd_ >= 0) return std::string();
+            if(errno != EBUSY || attempt > 0) return error("cannot attach XDP program to network interface '" + interface + "'");
+
+            ::close(programFd_);
+            ::close(mapFd_);
+            programFd_ = mapFd_ = -1;
+        }
+    }
+
+    void close() {
+        if(linkFd_ >= 0) ::close(linkFd_);
+        if(programFd_ >= 0) ::close(programFd_);
+        if(mapFd_ >= 0) ::close(mapFd_);
+        if(rxMap_) munmap(rxMap_, rxMapSize_);
+        if(fillMap_) munmap(fillMap_, fillMapSize_);
+        if(fd_ >= 0) ::close(fd_);
+        if(umem_) munmap(umem_, umemSize_);
+        fd_ = mapFd_ = programFd_ = linkFd_ = -1;
+        umem_ = rxMap_ = fillMap_ = NULL;
+        umemSize_ = rxMapSize_ = fillMapSize_ = 0;
+    }
+
+    // Returns true if this socket attached the XDP program to the
+    // interface, false if another socket or tool attached it.
+    bool attached() const {
+        return programFd_ >= 0 && linkFd_ >= 0;
+    }
+
+    // Calls 'visitor' once with up to 'batch' packets waiting in the
+    // receive ring, and then gives their frames back to the kernel.  Returns
+    // the number of packets received.
+    template<typename Visitor>
+    size_t receive(Visitor &visitor, size_t batch) {
+        const uint32_t producer = __atomic_load_n(rx_.producer, __ATOMIC_ACQUIRE);
+        const uint32_t consumer = *rx_.consumer;
+        size_t count = producer - consumer;
+        if(count == 0) return 0;
+        if(count > batch) count = batch;
+        if(count > packets_.size()) packets_.resize(count);
+
+        for(size_t i = 0; i < count; ++i) {
+            const struct xdp_desc &descriptor = rx_[consumer + i];
+            packets_[i].iov_base = umem_ + descriptor.addr;
+            packets_[i].iov_len = descriptor.len;
+        }
+        visitor(&packets_[0], count);
+
+        // the fill ring has room for every frame, so it has room for these
+        const uint32_t fillProducer = *fill_.producer;
+        for(size_t i = 0; i < count; ++i) {
+            fill_[fillProducer + i] = rx_[consumer + i].addr & ~static_cast<uint64_t>(frameSize_ - 1);
+        }
+        __atomic_store_n(rx_.consumer, consumer + count, __ATOMIC_RELEASE);
+        __atomic_store_n(fill_.producer, fillProducer + count, __ATOMIC_RELEASE);
+
+        __atomic_store_n(&received_, received_ + count, __ATOMIC_RELAXED);
+        return count;
+    }
+
+    // Waits up to 'timeout' milliseconds for packets to arrive, waking the
+    // kernel up to refill its receive queue if it is waiting for frames.
+    void wait(int timeout) {
+        struct pollfd descriptor;
+        descriptor.fd = fd_;
+        descriptor.events = POLLIN;
+        descriptor.revents = 0;
+        poll(&descriptor, 1, timeout);
+    }
+
+    // Gets the number of packets received by the socket, and the number
+    // dropped because the receive ring was full or the kernel had no frames
+    // to put them in, since the socket was opened.
+    bool statistics(uint64_t &packets, uint64_t &drops) {
+        struct xdp_statistics stats;
+        memset(&stats, 0, sizeof(stats));
+        socklen_t length = sizeof(stats);
+        if(fd_ < 0 || getsockopt(fd_, SOL_XDP, XDP_STATISTICS, &stats, &length) != 0) return false;
+
+        // The kernel counts packets dropped because the receive ring was full,
+        // or the fill ring was empty, apart from those dropped for other reasons,
+        // but kernels older than 5.9 return only the shorter original structure.
+        packets = __atomic_load_n(&received_, __ATOMIC_RELAXED);
+        drops = stats.rx_dropped;
+        if(length >= offsetof(struct xdp_statistics, rx_fill_ring_empty_descs) + sizeof(stats.rx_fill_ring_empty_descs)) {
+            drops += stats.rx_ring_full + stats.rx_fill_ring_empty_descs;
+        }
+        return true;
+    }
+
+private:
+    XDPSocket(const XDPSocket &);
+    XDPSocket &operator=(const XDPSocket &);
+
+    // A ring mapped from the socket, with its producer and consumer indexes.
+    template<typename Entry>
+    struct ring {
+        ring(): producer(NULL), consumer(NULL), entries(NULL), mask(0) {}
+
+        void attach(uint8_t *map, const struct xdp_ring_offset &offsets, uint32_t size) {
+            producer = reinterpret_cast<uint32_t *>(map + offsets.producer);
+            consumer = reinterpret_cast<uint32_t *>(map + offsets.consumer);
+            entries = reinterpret_cast<Entry *>(map + offsets.desc);
+            mask = size - 1;
+        }
+
+        Entry &operator[](uint32_t index) { return entries[index & mask]; }
+
+        uint32_t *producer;
+        uint32_t *consumer;
+        Entry *entries;
+        uint32_t mask;
+    };
+
+    static int bpf(int command, union bpf_attr &attr) {
+        return syscall(__NR_bpf, command, &attr, sizeof(attr));
+    }
+
+    static int openPinned(const std::string &path, std::string &message) {
+        union bpf_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.pathname = reinterpret_cast<uintptr_t>(path.c_str());
+        const int fd = bpf(BPF_OBJ_GET, attr);
+        if(fd < 0) message = "cannot open pinned BPF object '" + path + "'";
+        return fd;
+    }
+
+    // the number of entries in an XSKMAP created by a socket, which is
+    // shared by sockets on other queues, so it has room for all of the
+    // queues of most adapters
+    static const uint32_t MAP_SIZE = 256;
+
+    // the name of the program loaded by a socket, which identifies it to
+    // sockets on other queues
+    static const char *programName() { return "xsk_redirect"; }
+
+    static int createMap(uint32_t entries, std::string &message) {
+        union bpf_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.map_type = BPF_MAP_TYPE_XSKMAP;
+        attr.key_size = sizeof(uint32_t);
+        attr.value_size = sizeof(int);
+        attr.max_entries = entries;
+        const int fd = bpf(BPF_MAP_CREATE, attr);
+        if(fd < 0) message = "cannot create XSKMAP";
+        return fd;
+    }
+
+    // Adds this socket to the XSKMAP under the key 'queue'.
+    bool insert(uint32_t queue) {
+        uint32_t key = queue;
+        int value = fd_;
+        union bpf_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.map_fd = mapFd_;
+        attr.key = reinterpret_cast<uintptr_t>(&key);
+        attr.value = reinterpret_cast<uintptr_t>(&value);
+        attr.flags = BPF_ANY;
+        return bpf(BPF_MAP_UPDATE_ELEM, attr) == 0;
+    }
+
+    // Attaches an XDP program to interface 'ifindex' with a BPF link, and
+    // returns the link's file descriptor, or -1 with errno set to EBUSY if
+    // a program is attached already.
+    static int attach(int programFd, int ifindex, AttachMode mode) {
+        union bpf_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.link_create.prog_fd = programFd;
+        attr.link_create.target_ifindex = ifindex;
+        attr.link_create.attach_type = BPF_XDP;
+        attr.link_create.flags = (mode == NATIVE) ? XDP_FLAGS_DRV_MODE : XDP_FLAGS_SKB_MODE;
+        return bpf(BPF_LINK_CREATE, attr);
+    }
+
+    template<typename Info>
+    static bool objectInfo(int fd, Info &info) {
+        union bpf_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.info.bpf_fd = fd;
+        attr.info.info_len = sizeof(info);
+        attr.info.info = reinterpret_cast<uintptr_t>(&info);
+        return bpf(BPF_OBJ_GET_INFO_BY_FD, attr) == 0;
+    }
+
+    // Finds the BPF link that attaches another socket's program to
+    // interface 'ifindex', and opens the XSKMAP the program redirects
+    // packets through.  Returns the link's file descriptor, which keeps the
+    // program attached while it is open, or -1 if there is no such link.
+    static int findLink(int ifindex, int &mapFd) {
+        uint32_t id = 0;
+        while(true) {
+            union bpf_attr attr;
+            memset(&attr, 0, sizeof(attr));
+            attr.start_id = id;
+            if(bpf(BPF_LINK_GET_NEXT_ID, attr) != 0 || attr.next_id <= id) return -1;
+            id = attr.next_id;
+
+            memset(&attr, 0, sizeof(attr));
+            attr.link_id = id;
+            const int linkFd = bpf(BPF_LINK_GET_FD_BY_ID, attr);
+            if(linkFd < 0) continue; // detached since it was listed
+
+            struct bpf_link_info link;
+            memset(&link, 0, sizeof(link));
+            if(objectInfo(linkFd, link) && link.type == BPF_LINK_TYPE_XDP && static_cast<int>(link.xdp.ifindex) == ifindex) {
+                mapFd = openProgramMap(link.prog_id);
+                if(mapFd >= 0) return linkFd;
+            }
+            ::close(linkFd);
+        }
+    }
+
+    // Opens the map of program 'id', if it was loaded by a socket.
+    static int openProgramMap(uint32_t id) {
+        union bpf_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.prog_id = id;
+        const int programFd = bpf(BPF_PROG_GET_FD_BY_ID, attr);
+        if(programFd < 0) return -1;
+
+        uint32_t mapId = 0;
+        struct bpf_prog_info program;
+        memset(&program, 0, sizeof(program));
+        program.nr_map_ids = 1;
+        program.map_ids = reinterpret_cast<uintptr_t>(&mapId);
+        const bool found = objectInfo(programFd, program) && program.nr_map_ids == 1 && strcmp(program.name, programName()) == 0;
+        ::close(programFd);
+        if(!found) return -1;
+
+        memset(&attr, 0, sizeof(attr));
+        attr.map_id = mapId;
+        return bpf(BPF_MAP_GET_FD_BY_ID, attr);
+    }
+
+    // Loads the equivalent of this XDP program, which redirects each packet
+    // to the socket for its queue, or passes it to the kernel if there is
+    // none:
+    //
+    //     return bpf_redirect_map(&map, ctx->rx_queue_index, XDP_PASS);
+    int loadRedirectProgram(std::string &message) {
+        struct bpf_insn program[6];
+        memset(program, 0, sizeof(program));
+        program[0].code = BPF_LDX | BPF_MEM | BPF_W;          // r2 = ctx->rx_queue_index
+        program[0].dst_reg = BPF_REG_2;
+        program[0].src_reg = BPF_REG_1;
+        program[0].off = offsetof(struct xdp_md, rx_queue_index);
+        program[1].code = BPF_LD | BPF_DW | BPF_IMM;          // r1 = map
+        program[1].dst_reg = BPF_REG_1;
+        program[1].src_reg = BPF_PSEUDO_MAP_FD;
+        program[1].imm = mapFd_;
+        program[3].code = BPF_ALU64 | BPF_MOV | BPF_K;        // r3 = XDP_PASS
+        program[3].dst_reg = BPF_REG_3;
+        program[3].imm = XDP_PASS;
+        program[4].code = BPF_JMP | BPF_CALL;                 // r0 = bpf_redirect_map(r1, r2, r3)
+        program[4].imm = BPF_FUNC_redirect_map;
+        program[5].code = BPF_JMP | BPF_EXIT;                 // return r0
+
+        static const char license[] = "GPL";
+        union bpf_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.prog_type = BPF_PROG_TYPE_XDP;
+        attr.insns = reinterpret_cast<uintptr_t>(program);
+        attr.insn_cnt = sizeof(program) / sizeof(program[0]);
+        attr.license = reinterpret_cast<uintptr_t>(license);
+        strncpy(attr.prog_name, programName(), sizeof(attr.prog_name) - 1);
+        const int fd = bpf(BPF_PROG_LOAD, attr);
+        if(fd < 0) message = "cannot load XDP program";
+        return fd;
+    }
+
+    std::string error(const std::string &what) {
+        std::string message = what + ", " + strerror(errno);
+        close();
+        return message;
+    }
+
+    int fd_;
+    int mapFd_;
+    int programFd_;
+    int linkFd_;
+    uint8_t *umem_;
+    size_t umemSize_;
+    uint32_t frameSize_;
+    uint8_t *rxMap_;
+    size_t rxMapSize_;
+    uint8_t *fillMap_;
+    size_t fillMapSize_;
+    ring<struct xdp_desc> rx_;
+    ring<uint64_t> fill_;
+    std::vector<struct iovec> packets_;
+    uint64_t received_;
+};
+
+} } } }
+
+#endif
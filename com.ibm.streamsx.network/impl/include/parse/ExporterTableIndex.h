@@ -0,0 +1,40 @@
+/*
+** Copyright (C) 2026  International Business Machines Corporation
+** All Rights Reserved
+*/
+
+#ifndef EXPORTER_TABLE_INDEX_H_
+#define EXPORTER_TABLE_INDEX_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <tr1/unordered_map>
+
+////////////////////////////////////////////////////////////////////////////////
+// The IPFIX and Netflow message parsers keep state tables indexed by the
+// address and port of the exporter that sent the message, the source
+// identifier in its header, and, for templates, the template identifier.
+// Templates are scoped to the exporter's transport session, so two exporting
+// processes on the same device that use different ports do not overwrite
+// each other's templates.
+////////////////////////////////////////////////////////////////////////////////
+
+struct ExporterTableIndex {
+  uint32_t sourceAddress;
+  uint32_t sourceID;
+  uint16_t sourcePort;
+  uint16_t templateID;
+  bool operator==(const ExporterTableIndex& other) const { return sourceAddress==other.sourceAddress && sourceID==other.sourceID && sourcePort==other.sourcePort && templateID==other.templateID; }
+};
+
+struct ExporterTableIndexHash {
+  size_t operator()(const ExporterTableIndex& index) const { return std::tr1::hash<uint64_t>()( ( ((uint64_t)index.sourceAddress)<<32 | index.sourceID ) ^ ( ( ((uint64_t)index.sourcePort)<<16 | index.templateID ) * 0x9E3779B97F4A7C15ull ) ); }
+};
+
+inline ExporterTableIndex exporterTableIndex(uint32_t sourceAddress, uint16_t sourcePort, uint32_t sourceID, uint16_t templateID = 0) {
+  const ExporterTableIndex index = { sourceAddress, sourceID, sourcePort, templateID };
+  return index;
+}
+
+#endif /* EXPORTER_TABLE_INDEX_H_ */
@@ -17,6 +17,8 @@
 
 #include <SPL/Runtime/Type/SPLType.h>
 
+#include "ExporterTableIndex.h"
+
 // suppress "warning: operation on ‘((IPFIXMessageParser*)this)->IPFIXMessageParser::templateState->IPFIXMessageParser::TemplateState::dataLength’ may be undefined [-Wsequence-point]" message
 #pragma GCC diagnostic ignored "-Wsequence-point"
 
@@ -89,7 +91,7 @@ class IPFIXMessageParser {
     uint32_t previousSequenceNumber;
     uint16_t previousFlowCount;
   };
-  std::tr1::unordered_map<uint64_t, struct SourceState*> sourceTable; // indexed by sourceAddress+sourceID
+  std::tr1::unordered_map<ExporterTableIndex, struct SourceState*, ExporterTableIndexHash> sourceTable; // indexed by sourceAddress+sourcePort+sourceID
 
   // This table keeps track of the templates received from each source
   // Each template is stored as received in the 'template' variables and 
@@ -123,12 +125,14 @@ class IPFIXMessageParser {
       uint32_t enterpriseIdentifier; // identifier of enterprise field in data record, or zero if absent
     } dataFields[MAXIMUM_IDENTIFIER_VALUE+1]; // indexed by 'identifier' of 'template'
   };
-  std::tr1::unordered_map<uint64_t, struct TemplateState*> templateTable; // indexed by sourceAddress+sourceID+templateID
+  std::tr1::unordered_map<ExporterTableIndex, struct TemplateState*, ExporterTableIndexHash> templateTable; // indexed by sourceAddress+sourcePort+sourceID+templateID
 
   // The prepareIPFIXMessage() functions below stores the IP address of the
-  // source that sent the IPFIX message in this variable.
+  // source that sent the IPFIX message, and the UDP port it was sent
+  // from, if known, in these variables.
 
   uint32_t sourceAddress;
+  uint16_t sourcePort;
 
   uint64_t missedMessageCount;
 
@@ -194,7 +198,7 @@ class IPFIXMessageParser {
       const uint16_t templateID = ntohs(ipfixTemplate->templateID);
       if (templateID<256) { error = "IPFIX templateID too small"; return; }
       const uint32_t sourceID = ntohl(ipfixHeader->sourceID);
-      const uint64_t index = (((uint64_t)sourceAddress)<<32) + ((uint64_t)sourceID<<16) + ((uint64_t)templateID);
+      const ExporterTableIndex index = exporterTableIndex(sourceAddress, sourcePort, sourceID, templateID);
       struct TemplateState *templateState = templateTable[index];
       if (!templateState) {
         templateState = new TemplateState;
@@ -640,7 +644,7 @@ class IPFIXMessageParser {
   // This function prepares the parser for a IPFIX message. It sets
   // 'ipfixHeader', or sets 'error' if a problem is found.
 
-  void prepareIPFIXMessage(char* buffer, int length, uint32_t source) {
+  void prepareIPFIXMessage(char* buffer, int length, uint32_t source, uint16_t port = 0) {
 
       // clear all of the variables results will be returned in
       missedMessageCount = 0;
@@ -648,6 +652,7 @@ class IPFIXMessageParser {
       messageStart = NULL;
       messageEnd = NULL;
       sourceAddress = 0;
+      sourcePort = 0;
       ipfixHeader = NULL;
       ipfixSet = NULL;
       ipfixFlow = NULL;
@@ -666,6 +671,7 @@ class IPFIXMessageParser {
       messageStart = (uint8_t*)buffer;
       messageEnd = (uint8_t*)buffer + length;
       sourceAddress = source;
+      sourcePort = port;
 
     // point at the IPFIX header structure in the message
     if ( messageLength < sizeof(struct IPFIXHeader) ) { error = "header too short"; return; }
@@ -673,7 +679,7 @@ class IPFIXMessageParser {
 
     // find the state structure for this message's source, or create a new one
     const uint32_t sourceID = ntohl(ipfixHeader->sourceID);
-    const uint64_t index = ((uint64_t)sourceAddress)<<32 | (uint64_t)sourceID;
+    const ExporterTableIndex index = exporterTableIndex(sourceAddress, sourcePort, sourceID);
     struct SourceState* sourceState = sourceTable[index];
     if (!sourceState) {
         sourceState = new SourceState;
@@ -744,7 +750,7 @@ class IPFIXMessageParser {
 
           // find the template for this set; if we have not stored its template, skip this flow
           const uint32_t sourceID = ntohl(ipfixHeader->sourceID);
-          const uint64_t index = (((uint64_t)sourceAddress)<<32) + ((uint64_t)sourceID<<16) + ((uint64_t)setID);
+          const ExporterTableIndex index = exporterTableIndex(sourceAddress, sourcePort, sourceID, setID);
           templateState = templateTable[index];
           if (!templateState) { continue; }
 
@@ -17,6 +17,8 @@
 
 #include <SPL/Runtime/Type/SPLType.h>
 
+#include "ExporterTableIndex.h"
+
 // suppress " warning: array subscript is above array bounds [-Warray-bounds] " messages
 // from GCC version 4.8.3 in RHEL 7.1
 
@@ -138,7 +140,7 @@ class NetflowMessageParser {
     uint32_t previousSequenceNumber;
     uint16_t previousFlowCount;
   };
-  std::tr1::unordered_map<uint64_t, struct SourceState*> sourceTable; // indexed by sourceAddress+sourceID
+  std::tr1::unordered_map<ExporterTableIndex, struct SourceState*, ExporterTableIndexHash> sourceTable; // indexed by sourceAddress+sourcePort+sourceID
 
   // This table keeps track of the flow templates received from each processor
   // engine in each switch/router device. Each template is stored as received
@@ -158,12 +160,14 @@ class NetflowMessageParser {
     uint16_t flowTypeMaximum; // largest value of 'type' used in this template
     struct { uint16_t offset; uint16_t length; } flowFields[FLOW_FIELDS_MAXIMUM+1]; // offsets and lengths of fields in flows that use this template, indexed by field type
   };
-  std::tr1::unordered_map<uint64_t, struct TemplateState*> templateTable; // indexed by sourceAddress+sourceID+templateID
+  std::tr1::unordered_map<ExporterTableIndex, struct TemplateState*, ExporterTableIndexHash> templateTable; // indexed by sourceAddress+sourcePort+sourceID+templateID
 
   // The prepareNetflowMessage() functions below stores the IP address of the
-  // switch/router that sent the Netflow message in this variable.
+  // switch/router that sent the Netflow message, and the UDP port it was
+  // sent from, if known, in these variables.
 
   uint32_t sourceAddress;
+  uint16_t sourcePort;
 
   // The prepareNetflowMessage() function below keeps track of the Netflow
   // message being parsed in these variables.
@@ -264,7 +268,7 @@ class NetflowMessageParser {
 
     // find the state structure for this message's source, or create a new one
     const uint32_t sourceID = netflow5Header->engineID;
-    const uint64_t index = ((uint64_t)sourceAddress)<<32 | (uint64_t)sourceID;
+    const ExporterTableIndex index = exporterTableIndex(sourceAddress, sourcePort, sourceID);
     struct SourceState* sourceState = sourceTable[index];
     if (!sourceState) {
         sourceState = new SourceState;
@@ -303,7 +307,7 @@ class NetflowMessageParser {
       const uint16_t templateID = ntohs(netflow9Template->templateID);
       if (templateID<256) { error = "netflow9 templateID too small"; return; }
       const uint32_t sourceID = ntohl(netflow9Header->sourceID);
-      const uint64_t index = (((uint64_t)sourceAddress)<<32) + ((uint64_t)sourceID<<16) + ((uint64_t)templateID);
+      const ExporterTableIndex index = exporterTableIndex(sourceAddress, sourcePort, sourceID, templateID);
       struct TemplateState *templateState = templateTable[index];
       if (!templateState) {
         templateState = new TemplateState;
@@ -409,7 +413,7 @@ class NetflowMessageParser {
 
           // find the template for this flow; if we have not stored its template, skip this flow
           const uint32_t sourceID = ntohl(netflow9Header->sourceID);
-          const uint64_t index = (((uint64_t)sourceAddress)<<32) + ((uint64_t)sourceID<<16) + ((uint64_t)flowsetID);
+          const ExporterTableIndex index = exporterTableIndex(sourceAddress, sourcePort, sourceID, flowsetID);
           templateState = templateTable[index];
           if (!templateState) { continue; }
 
@@ -450,7 +454,7 @@ class NetflowMessageParser {
 
     // find the state structure for this message's source, or create a new one
     const uint32_t sourceID = ntohl(netflow9Header->sourceID);
-    const uint64_t index = ((uint64_t)sourceAddress)<<32 | (uint64_t)sourceID;
+    const ExporterTableIndex index = exporterTableIndex(sourceAddress, sourcePort, sourceID);
     struct SourceState* sourceState = sourceTable[index];
     if (!sourceState) {
         sourceState = new SourceState;
@@ -555,7 +559,7 @@ class NetflowMessageParser {
   // 'netflow5Header', depending upon the version of the message. It sets 'error' if a
   // problem is found.
 
-  void prepareNetflowMessage(char* buffer, int length, uint32_t source) {
+  void prepareNetflowMessage(char* buffer, int length, uint32_t source, uint16_t port = 0) {
 
       // clear all of the variables results will be returned in
       messageLength = 0;
@@ -563,6 +567,7 @@ class NetflowMessageParser {
       messageEnd = NULL;
       messageMissedCount = 0;
       sourceAddress = 0;
+      sourcePort = 0;
       netflow9Header = NULL;
       netflow5Header = NULL;
       netflow9Flowset = NULL;
@@ -585,6 +590,7 @@ class NetflowMessageParser {
       messageStart = (uint8_t*)buffer;
       messageEnd = (uint8_t*)buffer + length;
       sourceAddress = source;
+      sourcePort = port;
 
       // call the appropriate preparation function
       switch (ntohs(((struct NetflowCommonHeader*)messageStart)->version)) {
@@ -90,8 +90,93 @@ class NetworkHeaderParser {
       struct ethhdr etherHeader;
     } __attribute__((packed)) ;
 
+    // structures of Linux 'cooked' capture headers, versions 1 and 2, which
+    // replace ethernet headers in packets captured from the 'any' interface
+
+    struct LinuxSLLHeader {
+      uint16_t packetType;                // sent to us, broadcast, multicast, sent by us, etc
+      uint16_t addressType;               // ARPHRD_ type of link-layer address
+      uint16_t addressLength;             // length of link-layer source address
+      uint8_t address[8];                 // link-layer source address, padded with zeros
+      uint16_t protocol;                  // ether type of packet
+    } __attribute__((packed)) ;
+
+    struct LinuxSLL2Header {
+      uint16_t protocol;                  // ether type of packet
+      uint16_t reserved;
+      uint32_t interfaceIndex;            // index of interface packet was captured on
+      uint16_t addressType;               // ARPHRD_ type of link-layer address
+      uint8_t packetType;                 // sent to us, broadcast, multicast, sent by us, etc
+      uint8_t addressLength;              // length of link-layer source address
+      uint8_t address[8];                 // link-layer source address, padded with zeros
+    } __attribute__((packed)) ;
+
+    // structure of Virtual eXtensible LAN (VXLAN) header
+
+    struct VXLANHeader {
+      uint8_t flags;                      // flags, of which only 'VNI present' must be set
+      static const uint8_t vniFlag = 0x08;
+      uint8_t reserved[3];
+      uint32_t vni;                       // network identifier, in the upper 24 bits, followed by a reserved byte
+    } __attribute__((packed)) ;
+
+    // structure of Generic Network Virtualization Encapsulation (Geneve) header
+
+    struct GeneveHeader {
+      uint8_t versionAndOptionsLength;    // header version (must be zero), and length of options, in 4-byte words
+      static const uint8_t version       = 0xC0;
+      static const uint8_t optionsLength = 0x3F;
+      uint8_t flags;                      // flags for control packets and critical options
+      uint16_t protocolType;              // ether type of encapsulated packet, usually 0x6558 for ethernet
+      uint32_t vni;                       // network identifier, in the upper 24 bits, followed by a reserved byte
+      uint32_t options[0];                // optional variable-length options
+    } __attribute__((packed)) ;
+
+    // structure of GPRS Tunnelling Protocol user plane (GTP-U) header
+
+    struct GTPUHeader {
+      uint8_t flags;                      // header version and flags for optional fields
+      static const uint8_t version        = 0xE0; // version of this header (must be 1)
+      static const uint8_t protocolType   = 0x10; // GTP, rather than GTP', (must be set)
+      static const uint8_t extensionFlag  = 0x04; // extension headers follow
+      static const uint8_t sequenceFlag   = 0x02; // sequence number is present
+      static const uint8_t npduFlag       = 0x01; // N-PDU number is present
+      uint8_t messageType;                // type of message, 0xFF for encapsulated user packets (G-PDU)
+      uint16_t length;                    // length of the packet after this header
+      uint32_t teid;                      // tunnel endpoint identifier
+      uint16_t sequence[0];               // optional fields, present if any of the flags above are set
+    } __attribute__((packed)) ;
+
+    // structure of PPP over ethernet (PPPoE) session header, including the PPP protocol
+
+    struct PPPoEHeader {
+      uint8_t versionAndType;             // header version and type (both must be 1)
+      uint8_t code;                       // code (must be zero for session packets)
+      uint16_t session;                   // session identifier
+      uint16_t length;                    // length of PPP packet
+      uint16_t protocol;                  // PPP protocol of packet, 0x0021 for IPv4 or 0x0057 for IPv6
+    } __attribute__((packed)) ;
+
     static const uint8_t greProtocol = 47; // value of IP header 'protocol' field for GRE packets
     static const uint16_t erspanProtocolType = 0x88BE; // value of GRE header 'protocolType' field for ERSPAN2 packets
+    static const uint16_t erspan3ProtocolType = 0x22EB; // value of GRE header 'protocolType' field for ERSPAN3 packets
+
+
+    // The parseNetworkHeaders() function below walks through the layers of
+    // headers in a packet, decoding each one to find which follows it, until
+    // it reaches the innermost transport header, or a header it does not
+    // decode.  It returns the type, address and length of each layer in the
+    // 'layers' array below, up to 'maxLayers' of them.
+
+    enum LayerType { noLayer, etherLayer, vlanLayer, mplsLayer, pppoeLayer, ipv4Layer, ipv6Layer, extensionLayer, greLayer, erspanLayer, vxlanLayer, geneveLayer, gtpuLayer, jmirrorLayer, udpLayer, tcpLayer };
+
+    struct Layer {
+      LayerType type;
+      char* header;
+      int length;
+    };
+
+    static const int maxLayers = 16;
 
 
     // The parseNetworkHeaders() function below returns the address and length
@@ -102,7 +187,13 @@ class NetworkHeaderParser {
 
     // The parsePacketHeaders() function below returns the addresses and lengths
     // of the packet's network headers and payload data in these variables, if
-    // present, or NULL and zero, if absent.
+    // present, or NULL and zero, if absent.  When the packet encapsulates other
+    // packets, these are the headers of the innermost one, except that an
+    // encapsulated ethernet frame that does not contain an IP packet, such as
+    // an ARP packet, leaves the headers outside it in place.  The 'vlanHeader'
+    // tags are those of the innermost ethernet header, the 'ipv6HeaderLength'
+    // includes any IPv6 extension headers, and 'ipProtocol' is the protocol
+    // that follows them.
 
     struct JMirrorHeaders* jmirrorHeader; int jmirrorHeaderLength;
     struct ERSPAN2Headers* erspanHeader; int erspanHeaderLength;
@@ -114,18 +205,45 @@ class NetworkHeaderParser {
     struct udphdr*  udpHeader;   int udpHeaderLength;
     struct tcphdr*  tcpHeader;   int tcpHeaderLength;
     char*           payload;     int payloadLength;
+    uint8_t         ipProtocol;
+
+    // The parseNetworkHeaders() function below returns the addresses of the
+    // outermost ethernet, IP, and UDP headers in the packet in these
+    // variables, if present, or NULL, if absent.  When the packet does not
+    // encapsulate other packets, these are the same as the headers above.
+
+    struct ethhdr*  outerEtherHeader;
+    struct iphdr*   outerIPv4Header;
+    struct ip6_hdr* outerIPv6Header;
+    struct udphdr*  outerUDPHeader;
+
+    // The parseNetworkHeaders() function below returns all of the layers of
+    // headers in the packet, outermost first, in these variables.
+
+    struct Layer layers[maxLayers]; int layerCount;
 
 
     // The parseNetworkHeaders() function below locates the network headers and
     // payload data in the ethernet packet contained in the specified buffer and
     // returns them in the variables above.
 
-    // Note: this function does not yet handle variable-length ethernet headers,
-    // such as those with VLAN tags, or variable-length IPv6 headers, such as
-    // those with extension headers
+    // It steps over IEEE 802.1Q and 802.1ad VLAN tags, MPLS labels, PPPoE
+    // session headers, and IPv6 extension headers, and decodes packets
+    // encapsulated in IP-in-IP, GRE (including ERSPAN types I, II, and III),
+    // VXLAN, Geneve, GTP-U, MPLS-in-UDP, and Juniper Networks 'jmirror'
+    // tunnels.  It does not decode anything after an IP fragment other than
+    // the first.
+
+    // Packets captured from 'raw IP' links begin with an IPv4 or IPv6 header,
+    // without an ethernet header, and packets captured from Linux 'cooked'
+    // links begin with a Linux SLL or SLL2 header instead of an ethernet
+    // header.  For these packets, 'etherHeader' is NULL, and the IP header is
+    // located in place, without copying the packet.
 
+    enum LinkType { ethernetLink, rawIPLink, linuxSLLLink, linuxSLL2Link };
 
-    void parseNetworkHeaders(char* buffer, int length, bool jmirrorEnable = false) {
+
+    void parseNetworkHeaders(char* buffer, int length, bool jmirrorEnable = false, LinkType linkType = ethernetLink) {
 
         // store address and length of packet for the output attribute assignment functions
         packetBuffer = buffer;
@@ -136,138 +254,454 @@ class NetworkHeaderParser {
         erspanHeader = NULL; erspanHeaderLength = 0;
         vlanHeader = NULL;  vlanHeaderLength = 0;
         etherHeader = NULL; etherHeaderLength = 0;
+        clearIPHeaders();
+        payload = NULL; payloadLength = 0;
+        outerEtherHeader = NULL;
+        outerIPv4Header = NULL;
+        outerIPv6Header = NULL;
+        outerUDPHeader = NULL;
+        layerCount = 0;
+        savedLayerCount = -1;
+
+        LayerType layer;
+        if (linkType==rawIPLink) {
+
+          // if the buffer is empty, give up; otherwise, take the first layer from the IP version
+          layer = ipVersionLayer(buffer, length);
+
+        } else if (linkType==linuxSLLLink) {
+
+          // if the buffer isn't big enough for a Linux SLL header, give up; otherwise, step over it
+          if (length<(int)sizeof(struct LinuxSLLHeader)) return;
+          layer = etherTypeLayer(ntohs(((struct LinuxSLLHeader*)buffer)->protocol));
+          buffer += sizeof(struct LinuxSLLHeader);
+          length -= sizeof(struct LinuxSLLHeader);
+
+        } else if (linkType==linuxSLL2Link) {
+
+          // if the buffer isn't big enough for a Linux SLL2 header, give up; otherwise, step over it
+          if (length<(int)sizeof(struct LinuxSLL2Header)) return;
+          layer = etherTypeLayer(ntohs(((struct LinuxSLL2Header*)buffer)->protocol));
+          buffer += sizeof(struct LinuxSLL2Header);
+          length -= sizeof(struct LinuxSLL2Header);
+
+        } else {
+
+          layer = etherLayer;
+        }
+
+        // decode each layer of headers in turn, until there is nothing more to
+        // decode, or too many layers, and step over it
+        while (layer!=noLayer && layerCount<maxLayers) {
+            LayerType nextLayer = noLayer;
+            const int headerLength = parseLayer(layer, buffer, length, jmirrorEnable, nextLayer);
+            if (!headerLength) break;
+
+            layers[layerCount].type = layer;
+            layers[layerCount].header = buffer;
+            layers[layerCount].length = headerLength;
+            layerCount++;
+            buffer += headerLength;
+            length -= headerLength;
+            layer = nextLayer;
+        }
+
+        // if a tunnel encapsulates an ethernet frame that does not contain an IP packet,
+        // keep the headers outside the tunnel, and the payload that follows the last of them
+        if (savedLayerCount>=0) {
+            restoreHeaders();
+            for (int i=savedLayerCount-1; i>=0; i--) {
+              const LayerType type = layers[i].type;
+              if ( type==ipv4Layer || type==ipv6Layer || type==extensionLayer || type==udpLayer || type==tcpLayer ) {
+                buffer = layers[i].header + layers[i].length;
+                length = packetBuffer + packetLength - buffer;
+                break;
+              }
+            }
+        }
+
+        // if the innermost packet is an IPv4 or IPv6 packet, and there is any data
+        // left in the buffer, its the packet's payload
+        if ( (ipv4Header || ipv6Header) && length>0 ) {
+            payload = buffer;
+            payloadLength = length;
+        }
+    }
+
+    SPL::list<SPL::uint16> convertVlanTagsToList() {
+    	SPL::list<SPL::uint16> vList;
+    	int numIds = vlanHeaderLength / sizeof(struct VLANHeader);
+    	for (int i = 0;  i < numIds; i++)
+    	  vList.push_back( ntohs(vlanHeader[i].vlanTag) & VLANHeader::vlanIdentifier );
+    	return vList;
+    }
+
+
+ private:
+
+
+    // These tables map the ether types, IP protocols, and UDP destination ports
+    // that identify each kind of header to the layer that decodes it.
+
+    struct NextLayer {
+      uint16_t value;
+      LayerType layer;
+    };
+
+    static LayerType lookupLayer(const NextLayer* table, int count, uint16_t value) {
+        for (int i=0; i<count; i++) if (table[i].value==value) return table[i].layer;
+        return noLayer;
+    }
+
+    static LayerType etherTypeLayer(uint16_t etherType) {
+        static const NextLayer table[] = {
+          { ETH_P_IP,           ipv4Layer },
+          { ETH_P_IPV6,         ipv6Layer },
+          { ETH_P_8021Q,        vlanLayer },
+          { ETH_P_8021AD,       vlanLayer },
+          { 0x9100,             vlanLayer },   // pre-standard QinQ
+          { ETH_P_MPLS_UC,      mplsLayer },
+          { ETH_P_MPLS_MC,      mplsLayer },
+          { ETH_P_PPP_SES,      pppoeLayer },
+          { ETH_P_TEB,          etherLayer },  // transparent ethernet bridging, in GRE and Geneve
+          { erspanProtocolType, erspanLayer },
+          { erspan3ProtocolType, erspanLayer } };
+        return lookupLayer(table, sizeof(table)/sizeof(table[0]), etherType);
+    }
+
+    static LayerType ipProtocolLayer(uint8_t protocol) {
+        static const NextLayer table[] = {
+          { IPPROTO_TCP,      tcpLayer },
+          { IPPROTO_UDP,      udpLayer },
+          { IPPROTO_GRE,      greLayer },
+          { IPPROTO_IPIP,     ipv4Layer },
+          { IPPROTO_IPV6,     ipv6Layer },
+          { IPPROTO_HOPOPTS,  extensionLayer },
+          { IPPROTO_ROUTING,  extensionLayer },
+          { IPPROTO_FRAGMENT, extensionLayer },
+          { IPPROTO_DSTOPTS,  extensionLayer },
+          { IPPROTO_AH,       extensionLayer },
+          { 135,              extensionLayer },  // mobility
+          { 139,              extensionLayer },  // host identity protocol
+          { 140,              extensionLayer },  // shim6
+          { 137,              mplsLayer } };     // MPLS in IP
+        return lookupLayer(table, sizeof(table)/sizeof(table[0]), protocol);
+    }
+
+    static LayerType udpPortLayer(uint16_t port) {
+        static const NextLayer table[] = {
+          { 4789,        vxlanLayer },
+          { 6081,        geneveLayer },
+          { 2152,        gtpuLayer },
+          { 6635,        mplsLayer },   // MPLS in UDP
+          { jmirrorPort, jmirrorLayer } };
+        return lookupLayer(table, sizeof(table)/sizeof(table[0]), port);
+    }
+
+    // Tunnels that carry IP packets without saying which version they are
+    // leave it to the first nibble of the packet.
+
+    static LayerType ipVersionLayer(const char* buffer, int length) {
+        if (length<1) return noLayer;
+        const uint8_t ipVersion = ((uint8_t)buffer[0])>>4;
+        return ipVersion==4 ? ipv4Layer : ( ipVersion==6 ? ipv6Layer : noLayer );
+    }
+
+
+    // A new ethernet header or IP header inside a tunnel replaces the headers
+    // that follow it in the variables above.  An ethernet header inside a tunnel
+    // saves the headers outside it first, in case its frame does not contain an
+    // IP packet.
+
+    struct SavedHeaders {
+      struct JMirrorHeaders* jmirrorHeader; int jmirrorHeaderLength;
+      struct ERSPAN2Headers* erspanHeader; int erspanHeaderLength;
+      struct ethhdr*  etherHeader; int etherHeaderLength;
+      struct VLANHeader* vlanHeader; int vlanHeaderLength;
+      struct iphdr*   ipv4Header;  int ipv4HeaderLength;
+      struct ip6_hdr* ipv6Header;  int ipv6HeaderLength;
+      struct ip6_frag* ipv6FragmentHeader;  int ipv6FragmentHeaderLength;
+      struct udphdr*  udpHeader;   int udpHeaderLength;
+      struct tcphdr*  tcpHeader;   int tcpHeaderLength;
+      uint8_t         ipProtocol;
+    } saved;
+    int savedLayerCount; // number of layers outside the saved headers' tunnel, or -1 if none are saved
+
+    void saveHeaders() {
+        saved.jmirrorHeader = jmirrorHeader; saved.jmirrorHeaderLength = jmirrorHeaderLength;
+        saved.erspanHeader = erspanHeader; saved.erspanHeaderLength = erspanHeaderLength;
+        saved.etherHeader = etherHeader; saved.etherHeaderLength = etherHeaderLength;
+        saved.vlanHeader = vlanHeader; saved.vlanHeaderLength = vlanHeaderLength;
+        saved.ipv4Header = ipv4Header; saved.ipv4HeaderLength = ipv4HeaderLength;
+        saved.ipv6Header = ipv6Header; saved.ipv6HeaderLength = ipv6HeaderLength;
+        saved.ipv6FragmentHeader = ipv6FragmentHeader; saved.ipv6FragmentHeaderLength = ipv6FragmentHeaderLength;
+        saved.udpHeader = udpHeader; saved.udpHeaderLength = udpHeaderLength;
+        saved.tcpHeader = tcpHeader; saved.tcpHeaderLength = tcpHeaderLength;
+        saved.ipProtocol = ipProtocol;
+        savedLayerCount = layerCount;
+    }
+
+    void restoreHeaders() {
+        jmirrorHeader = saved.jmirrorHeader; jmirrorHeaderLength = saved.jmirrorHeaderLength;
+        erspanHeader = saved.erspanHeader; erspanHeaderLength = saved.erspanHeaderLength;
+        etherHeader = saved.etherHeader; etherHeaderLength = saved.etherHeaderLength;
+        vlanHeader = saved.vlanHeader; vlanHeaderLength = saved.vlanHeaderLength;
+        ipv4Header = saved.ipv4Header; ipv4HeaderLength = saved.ipv4HeaderLength;
+        ipv6Header = saved.ipv6Header; ipv6HeaderLength = saved.ipv6HeaderLength;
+        ipv6FragmentHeader = saved.ipv6FragmentHeader; ipv6FragmentHeaderLength = saved.ipv6FragmentHeaderLength;
+        udpHeader = saved.udpHeader; udpHeaderLength = saved.udpHeaderLength;
+        tcpHeader = saved.tcpHeader; tcpHeaderLength = saved.tcpHeaderLength;
+        ipProtocol = saved.ipProtocol;
+    }
+
+    void clearIPHeaders() {
         ipv4Header = NULL; ipv4HeaderLength = 0;
         ipv6Header = NULL; ipv6HeaderLength = 0;
         ipv6FragmentHeader = NULL; ipv6FragmentHeaderLength = 0;
         udpHeader = NULL; udpHeaderLength = 0;
         tcpHeader = NULL; tcpHeaderLength = 0;
-        payload = NULL; payloadLength = 0;
+        ipProtocol = 0;
+    }
+
+
+    // This function decodes one layer of headers at the start of the buffer,
+    // records it in the variables above, and returns its length and the layer
+    // that follows it, or zero if the buffer does not contain a valid header.
+
+    int parseLayer(LayerType layer, char* buffer, int length, bool jmirrorEnable, LayerType& nextLayer) {
+
+        switch (layer) {
+
+        case etherLayer: {
+            if (length<(int)sizeof(struct ethhdr)) return 0;
+            if (layerCount) saveHeaders();
+            etherHeader = (struct ethhdr*)buffer;
+            etherHeaderLength = sizeof(struct ethhdr); // ... not including optional VLAN tags
+            vlanHeader = NULL; vlanHeaderLength = 0;
+            clearIPHeaders();
+            if (!outerEtherHeader) outerEtherHeader = etherHeader;
+            nextLayer = etherTypeLayer(ntohs(etherHeader->h_proto));
+            return sizeof(struct ethhdr);
+        }
+
+        case vlanLayer: {
+            // step over all of the IEEE 802.1Q and 802.1ad VLAN tags at once
+            struct VLANHeader* vlan = (struct VLANHeader*)buffer;
+            int count = 0;
+            bool last = false;
+            while ( !last && (count+1)*(int)sizeof(struct VLANHeader)<=length ) {
+              nextLayer = etherTypeLayer(ntohs(vlan[count++].protocol));
+              last = nextLayer!=vlanLayer;
+            }
+            if (!last) nextLayer = noLayer;
+            if (!count) return 0;
+            vlanHeader = vlan;
+            vlanHeaderLength = count * sizeof(struct VLANHeader);
+            return vlanHeaderLength;
+        }
+
+        case mplsLayer: {
+            // step over the MPLS label stack, down to the label with the 'bottom of stack' bit set
+            int headerLength = 0;
+            bool bottom = false;
+            while ( !bottom && headerLength+4<=length ) {
+              bottom = ((uint8_t)buffer[headerLength+2]) & 0x01;
+              headerLength += 4;
+            }
+            if (!bottom) return 0;
+
+            // the label stack does not say what it carries, so guess from the first nibble after it,
+            // which is zero for a pseudowire control word followed by an ethernet header
+            if ( headerLength<length && ((uint8_t)buffer[headerLength])>>4==0 ) {
+              headerLength += 4;
+              nextLayer = etherLayer;
+            } else {
+              nextLayer = ipVersionLayer(buffer+headerLength, length-headerLength);
+            }
+            return headerLength;
+        }
+
+        case pppoeLayer: {
+            if (length<(int)sizeof(struct PPPoEHeader)) return 0;
+            struct PPPoEHeader* pppoe = (struct PPPoEHeader*)buffer;
+            if ( pppoe->versionAndType!=0x11 || pppoe->code!=0 ) return 0;
+            const uint16_t protocol = ntohs(pppoe->protocol);
+            nextLayer = protocol==0x0021 ? ipv4Layer : ( protocol==0x0057 ? ipv6Layer : noLayer );
+            return sizeof(struct PPPoEHeader);
+        }
 
-        // if the buffer isn't big enough for an ethernet header, give up
-        if (length<sizeof(struct ethhdr)) return;
-
-        // overlay an ethernet header on the buffer and step over it
-        etherHeader = (struct ethhdr*)buffer;
-        uint16_t etherType = ntohs(etherHeader->h_proto);
-        etherHeaderLength = sizeof(struct ethhdr); // ... not including optional VLAN tags
-        //printf("ethernet: "); for (int i=0; i<etherHeaderLength; i++) printf("%02x ", (uint8_t)buffer[i]); printf("\n");
-        buffer += etherHeaderLength;
-        length -= etherHeaderLength;
-
-        // if the ethernet header has one or more IEEE 802.1Q VLAN headers, 
-        // remember where they are in the buffer and step over them
-        if (ETH_P_8021Q == etherType) {
-          vlanHeader = (struct VLANHeader*) buffer;
-          vlanHeaderLength = sizeof(VLANHeader);
-          struct VLANHeader *nextVLAN = vlanHeader;
-          etherType = ntohs(nextVLAN->protocol);
-          while(ETH_P_8021Q == etherType) {
-            vlanHeaderLength += sizeof(VLANHeader);
-            nextVLAN++;
-            etherType = ntohs(nextVLAN->protocol);
-          } ;
-      	  buffer += vlanHeaderLength;
-      	  length -= vlanHeaderLength;
+        case ipv4Layer: {
+            struct iphdr* ip = (struct iphdr*)buffer;
+            if ( length<(int)sizeof(struct iphdr) || ip->version!=4 || ip->ihl<5 || ip->ihl*4>length ) return 0;
+            savedLayerCount = -1;
+            clearIPHeaders();
+            ipv4Header = ip;
+            ipv4HeaderLength = ip->ihl * 4;
+            ipProtocol = ip->protocol;
+            if ( !outerIPv4Header && !outerIPv6Header ) outerIPv4Header = ip;
+
+            // only the first fragment of a packet contains the headers that follow the IP header,
+            // and IPv6 extension headers other than AH do not follow IPv4 headers
+            if ( (ntohs(ip->frag_off)&0x1FFF)==0 ) nextLayer = ipProtocolLayer(ip->protocol);
+            if ( nextLayer==extensionLayer && ip->protocol!=IPPROTO_AH ) nextLayer = noLayer;
+            return ipv4HeaderLength;
         }
-        //if (vlanHeader) printf("    VLAN: "); for (int i=0; i<vlanHeaderLength; i++) printf("%02x ", (uint8_t)(((uint8_t*)vlanHeader)[i]) ); printf("\n");
-
-        // if the buffer contains a Juniper Networks mirror packet, step over the 'jmirror' headers
-        // (note that field tests are not in natural order so the inner 'if' will fail faster in the usual case)
-        if ( jmirrorEnable && length>=sizeof(struct JMirrorHeaders) ) {
-            struct JMirrorHeaders* jmirror = (struct JMirrorHeaders*)buffer;
-            if ( ntohs(jmirror->udpHeader.dest)==jmirrorPort &&
-                 jmirror->ipHeader.version==4 &&
-                 jmirror->ipHeader.ihl==5 &&
-                 jmirror->ipHeader.protocol==IPPROTO_UDP ) {
-              jmirrorHeader = jmirror;
-              jmirrorHeaderLength = sizeof(struct JMirrorHeaders);
-              buffer += sizeof(struct JMirrorHeaders);
-              length -= sizeof(struct JMirrorHeaders);
+
+        case ipv6Layer: {
+            struct ip6_hdr* ip = (struct ip6_hdr*)buffer;
+            if ( length<(int)sizeof(struct ip6_hdr) || (ip->ip6_vfc)>>4!=6 ) return 0;
+            savedLayerCount = -1;
+            clearIPHeaders();
+            ipv6Header = ip;
+            ipv6HeaderLength = sizeof(struct ip6_hdr); // ... plus length of extension headers, as they are stepped over
+            ipProtocol = ip->ip6_nxt;
+            if ( !outerIPv4Header && !outerIPv6Header ) outerIPv6Header = ip;
+            nextLayer = ipProtocolLayer(ip->ip6_nxt);
+            return sizeof(struct ip6_hdr);
+        }
+
+        case extensionLayer: {
+            // step over one IPv6 extension header, or an IPv4 authentication header
+            if (length<8) return 0;
+            const uint8_t* extension = (const uint8_t*)buffer;
+            int headerLength;
+            bool laterFragment = false;
+            if (ipProtocol==IPPROTO_FRAGMENT) {
+              headerLength = sizeof(struct ip6_frag);
+              ipv6FragmentHeader = (struct ip6_frag*)buffer;
+              ipv6FragmentHeaderLength = sizeof(struct ip6_frag);
+              laterFragment = (ntohs(ipv6FragmentHeader->ip6f_offlg)&0xFFF8)!=0;
+            } else if (ipProtocol==IPPROTO_AH) {
+              headerLength = (extension[1]+2) * 4;
+            } else {
+              headerLength = (extension[1]+1) * 8;
             }
+            if (headerLength>length) return 0;
+            if (ipv6Header) ipv6HeaderLength += headerLength;
+            ipProtocol = extension[0];
+
+            // only the first fragment of a packet contains the headers that follow the fragment header
+            if (!laterFragment) nextLayer = ipProtocolLayer(ipProtocol);
+            if ( nextLayer==extensionLayer && !ipv6Header && ipProtocol!=IPPROTO_AH ) nextLayer = noLayer;
+            return headerLength;
+        }
+
+        case greLayer: {
+            // step over the GRE header and its optional fields, except for the obsolete routing field
+            if (length<(int)sizeof(struct GREHeader)) return 0;
+            struct GREHeader* gre = (struct GREHeader*)buffer;
+            const uint16_t greHeaderFlags = ntohs(gre->flags);
+            if ( greHeaderFlags&(GREHeader::version|GREHeader::routingFlag) ) return 0;
+            const int headerLength = sizeof(struct GREHeader) +
+              ( greHeaderFlags&GREHeader::checksumFlag ? 4 : 0 ) +
+              ( greHeaderFlags&GREHeader::keyFlag ? 4 : 0 ) +
+              ( greHeaderFlags&GREHeader::sequenceFlag ? 4 : 0 );
+            if (headerLength>length) return 0;
+
+            // ERSPAN type I has no header of its own, and is distinguished from type II by the absence of a sequence number
+            const uint16_t protocolType = ntohs(gre->protocolType);
+            nextLayer = protocolType==erspanProtocolType && !(greHeaderFlags&GREHeader::sequenceFlag) ? etherLayer : etherTypeLayer(protocolType);
+            return headerLength;
         }
 
-        // if the buffer contains a GRE ERSPAN packet, step over the GRE and ERSPAN headers
-        // (note that field tests are not in natural order so the inner 'if' will fail faster in the usual case)
-        if ( length>=sizeof(struct ERSPAN2Headers) ) {
-            struct ERSPAN2Headers* erspan = (struct ERSPAN2Headers*)buffer;
-            if ( ntohs(erspan->greHeader.protocolType)==erspanProtocolType && 
-                 erspan->ipHeader.protocol==greProtocol && 
-                 erspan->ipHeader.version==4 &&
-                 erspan->ipHeader.ihl==5 ) {
-              uint16_t greHeaderFlags = ntohs(erspan->greHeader.flags);
-              int greHeaderLength = 
-                ( greHeaderFlags&GREHeader::checksumFlag ? 4 : 0 ) +
-                ( greHeaderFlags&GREHeader::routingFlag ? 4 : 0 ) +
-                ( greHeaderFlags&GREHeader::keyFlag ? 4 : 0 ) +
-                ( greHeaderFlags&GREHeader::sequenceFlag ? 4 : 0 );
-              erspanHeader = (struct ERSPAN2Headers*)buffer;
-              erspanHeaderLength = sizeof(struct ERSPAN2Headers) + greHeaderLength;
-              //???printf("IPv4+GRE+%d+ERSPAN+ethernet: ", greHeaderLength); for (int i=0; i<erspanHeaderLength; i++) printf("%02x ", (uint8_t)buffer[i]); printf("\n");
-              etherHeader = (struct ethhdr*)( (uint8_t*)(&erspan->etherHeader) + greHeaderLength );
-              etherHeaderLength = sizeof(struct ethhdr); // ... plus length of optional VLAN tag ?
-              //???printf("inner ethernet: "); for (int i=0; i<etherHeaderLength; i++) printf("%02x ", ((uint8_t*)etherHeader)[i]); printf("\n");
-              buffer += sizeof(struct ERSPAN2Headers) + greHeaderLength;
-              length -= sizeof(struct ERSPAN2Headers) + greHeaderLength;
+        case erspanLayer: {
+            // ERSPAN type II headers are 8 bytes long, and type III headers are 12 bytes long,
+            // plus 8 bytes for the optional platform-specific subheader
+            if (length<(int)sizeof(struct ERSPAN2Header)) return 0;
+            const uint8_t erspanVersion = ((uint8_t)buffer[0])>>4;
+            int headerLength;
+            if (erspanVersion==1) headerLength = sizeof(struct ERSPAN2Header);
+            else if ( erspanVersion==2 && length>=12 ) headerLength = 12 + ( buffer[11]&0x01 ? 8 : 0 );
+            else return 0;
+            if (headerLength>length) return 0;
+
+            // the ERSPAN header variables include the IPv4 header that carries the GRE header, if there is one
+            if ( layerCount>=2 && layers[layerCount-1].type==greLayer && layers[layerCount-2].type==ipv4Layer && ((struct iphdr*)layers[layerCount-2].header)->ihl==5 ) {
+              erspanHeader = (struct ERSPAN2Headers*)layers[layerCount-2].header;
+              erspanHeaderLength = (int)(buffer - layers[layerCount-2].header) + headerLength + sizeof(struct ethhdr);
             }
+            nextLayer = etherLayer;
+            return headerLength;
         }
 
+        case vxlanLayer: {
+            if (length<(int)sizeof(struct VXLANHeader)) return 0;
+            if ( !(((struct VXLANHeader*)buffer)->flags&VXLANHeader::vniFlag) ) return 0;
+            nextLayer = etherLayer;
+            return sizeof(struct VXLANHeader);
+        }
 
-        // if the buffer contains an IPv4 packet, overlay an IPv4 header on it
-        if ( etherType == ETH_P_IP && length>=sizeof(struct ip) && ((struct iphdr*)buffer)->version==4 ) {
-            ipv4Header = (struct iphdr*)buffer;
-            ipv4HeaderLength = ipv4Header->ihl * 4;
-            //???printf("IPv4: "); for (int i=0; i<ipv4HeaderLength; i++) printf("%02x ", (uint8_t)buffer[i]); printf("\n"); 
-            buffer += ipv4HeaderLength;
-            length -= ipv4HeaderLength;
+        case geneveLayer: {
+            if (length<(int)sizeof(struct GeneveHeader)) return 0;
+            struct GeneveHeader* geneve = (struct GeneveHeader*)buffer;
+            if (geneve->versionAndOptionsLength&GeneveHeader::version) return 0;
+            const int headerLength = sizeof(struct GeneveHeader) + (geneve->versionAndOptionsLength&GeneveHeader::optionsLength) * 4;
+            if (headerLength>length) return 0;
+            nextLayer = etherTypeLayer(ntohs(geneve->protocolType));
+            return headerLength;
         }
 
-        // if the buffer contains an IPv6 packet, overlay an IPv6 header on it
-        if ( etherType ==ETH_P_IPV6 && length>=sizeof(struct ip6_hdr) && (((struct ip6_hdr*)buffer)->ip6_vfc)>>4==6 ) {
-            ipv6Header = (struct ip6_hdr*)buffer;
-            ipv6HeaderLength = sizeof(struct ip6_hdr); // ... plus length of optional extension headers ?
-            //???printf("IPv6: "); for (int i=0; i<ipv6HeaderLength; i++) printf("%02x ", (uint8_t)buffer[i]); printf("\n"); 
-            buffer += ipv6HeaderLength;
-            length -= ipv6HeaderLength;
+        case gtpuLayer: {
+            // only G-PDU messages, version 1, carry user packets
+            if (length<(int)sizeof(struct GTPUHeader)) return 0;
+            struct GTPUHeader* gtpu = (struct GTPUHeader*)buffer;
+            if ( (gtpu->flags&(GTPUHeader::version|GTPUHeader::protocolType))!=0x30 || gtpu->messageType!=0xFF ) return 0;
+            int headerLength = sizeof(struct GTPUHeader);
+
+            // if any of the optional fields are present, they all are, and the last one
+            // is the type of the first extension header, each of which ends with the type of the next
+            if (gtpu->flags&(GTPUHeader::extensionFlag|GTPUHeader::sequenceFlag|GTPUHeader::npduFlag)) {
+              headerLength += 4;
+              if (headerLength>length) return 0;
+              uint8_t extensionType = (gtpu->flags&GTPUHeader::extensionFlag) ? (uint8_t)buffer[headerLength-1] : 0;
+              while (extensionType) {
+                if (headerLength>=length) return 0;
+                const int extensionLength = ((uint8_t)buffer[headerLength]) * 4;
+                if ( !extensionLength || headerLength+extensionLength>length ) return 0;
+                headerLength += extensionLength;
+                extensionType = (uint8_t)buffer[headerLength-1];
+              }
+            }
+            nextLayer = ipVersionLayer(buffer+headerLength, length-headerLength);
+            return headerLength;
         }
 
-        // if the buffer does not contain an IPv4 or IPv6 packet, give up
-        if ( ! (ipv4Header || ipv6Header ) ) return;
+        case jmirrorLayer: {
+            if (length<(int)sizeof(struct JMirrorHeader)) return 0;
+            jmirrorHeader = (struct JMirrorHeaders*)ipv4Header;
+            jmirrorHeaderLength = sizeof(struct JMirrorHeaders);
+            nextLayer = ipVersionLayer(buffer+sizeof(struct JMirrorHeader), length-sizeof(struct JMirrorHeader));
+            return sizeof(struct JMirrorHeader);
+        }
 
-        // if the buffer contains a UDP packet, and it has a UDP header, overlay a UDP header on it
-        if ( ( ipv4Header && ipv4Header->protocol==IPPROTO_UDP && (ntohs(ipv4Header->frag_off)&0x1FFF)==0 && length>=sizeof(struct udphdr) ) ||
-             ( ipv6Header && ipv6Header->ip6_nxt==IPPROTO_UDP && length>=sizeof(struct udphdr) ) ) {
+        case udpLayer: {
+            if (length<(int)sizeof(struct udphdr)) return 0;
             udpHeader = (struct udphdr*)buffer;
             udpHeaderLength = sizeof(struct udphdr);
-            //???printf("UDP: "); for (int i=0; i<udpHeaderLength; i++) printf("%02x ", (uint8_t)buffer[i]); printf("\n"); 
-            buffer += udpHeaderLength;
-            length -= udpHeaderLength;
+            if (!outerUDPHeader) outerUDPHeader = udpHeader;
+            nextLayer = udpPortLayer(ntohs(udpHeader->dest));
+
+            // 'jmirror' headers are recognized only when enabled, and only in the outermost IPv4 packet
+            if ( nextLayer==jmirrorLayer &&
+                 !( jmirrorEnable && ipv4Header && ipv4Header==outerIPv4Header && ipv4HeaderLength==sizeof(struct iphdr) && (char*)ipv4Header+ipv4HeaderLength==buffer ) )
+              nextLayer = noLayer;
+            return sizeof(struct udphdr);
         }
 
-        // if the buffer contains a TCP packet, and it has a TCP header, overlay a TCP header on it
-        if ( ( ipv4Header && ipv4Header->protocol==IPPROTO_TCP && (ntohs(ipv4Header->frag_off)&0x1FFF)==0 && length>=sizeof(struct tcphdr) ) ||
-             ( ipv6Header && ipv6Header->ip6_nxt==IPPROTO_TCP && length>=sizeof(struct tcphdr) ) ) {
-            tcpHeader = (struct tcphdr*)buffer;
-            tcpHeaderLength = tcpHeader->doff * 4;
-            //???printf("TCP: "); for (int i=0; i<tcpHeaderLength; i++) printf("%02x ", (uint8_t)buffer[i]); printf("\n"); 
-            buffer += tcpHeaderLength;
-            length -= tcpHeaderLength;
+        case tcpLayer: {
+            if (length<(int)sizeof(struct tcphdr)) return 0;
+            struct tcphdr* tcp = (struct tcphdr*)buffer;
+            if (tcp->doff<5) return 0;
+            tcpHeader = tcp;
+            tcpHeaderLength = tcp->doff * 4;
+            return tcpHeaderLength<length ? tcpHeaderLength : length;
         }
 
-        // if there is any data left in the buffer, its the packet's payload
-        if (length>0) {
-            payload = buffer;
-            payloadLength = length;
+        default:
+            return 0;
         }
     }
 
-    SPL::list<SPL::uint16> convertVlanTagsToList() {
-    	SPL::list<SPL::uint16> vList;
-    	int numIds = vlanHeaderLength / sizeof(struct VLANHeader);
-    	for (int i = 0;  i < numIds; i++)
-    	  vList.push_back( ntohs(vlanHeader[i].vlanTag) & VLANHeader::vlanIdentifier );
-    	return vList;
-    }
-
 };
 
 #endif /* NETWORK_HEADER_PARSER_H_ */
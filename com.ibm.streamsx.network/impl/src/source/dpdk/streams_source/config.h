@@ -76,6 +76,7 @@ struct rx_queue {
     uint8_t port_id;
     uint8_t queue_id;
     streams_packet_cb_t packetCallbackFunction;
+    streams_burst_cb_t burstCallbackFunction;   // if set, called once per burst instead of packetCallbackFunction
     void *userData;
 };
 
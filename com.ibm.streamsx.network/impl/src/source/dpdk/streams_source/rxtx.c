@@ -61,6 +61,7 @@ void addToMetric(struct Metric *m, uint64_t datum) {
 #define PREFETCH_OFFSET 1
 void receive_loop(struct lcore_conf *conf) {
     struct rte_mbuf *pkts_burst[MAX_PKT_BURST];
+    struct iovec iov_burst[MAX_PKT_BURST];
     unsigned i, portid;
     int j, num_rx, count;
 
@@ -117,6 +118,7 @@ void receive_loop(struct lcore_conf *conf) {
         for (i = 0; i < conf->num_rx_queue; i++) {
             portid = conf->rx_queue_list[i].port_id;
             streams_packet_cb_t packetCallback = conf->rx_queue_list[i].packetCallbackFunction;
+            streams_burst_cb_t burstCallback = conf->rx_queue_list[i].burstCallbackFunction;
             num_rx = rte_eth_rx_burst((uint32_t) portid, conf->rx_queue_list[i].queue_id,
                                       pkts_burst, MAX_PKT_BURST);
             DPDK_INST_TS(ts_B);
@@ -125,6 +127,30 @@ void receive_loop(struct lcore_conf *conf) {
                 DPDK_INST_UPDATE_METRIC(burstFoundDuration, ts_B - ts_A);
                 DPDK_INST_UPDATE_METRIC(packetCount, num_rx);
 
+                if (burstCallback) {
+                    // Hand the whole burst to the operator in one call, then
+                    // free the mbufs, which the operator has copied.
+                    for (j = 0; j < num_rx; j++) {
+                        rte_prefetch0(rte_pktmbuf_mtod(pkts_burst[j], void *));
+                        iov_burst[j].iov_base = rte_pktmbuf_mtod(pkts_burst[j], void *);
+                        iov_burst[j].iov_len = pkts_burst[j]->data_len;
+                    }
+
+                    DPDK_INST_TS(ts_C);
+                    burstCallback(conf->rx_queue_list[i].userData, iov_burst, num_rx, rte_rdtsc());
+                    DPDK_INST_TS(ts_D);
+                    for (j = 0; j < num_rx; j++) {
+                        rte_pktmbuf_free(pkts_burst[j]);
+                    }
+                    DPDK_INST_TS(ts_E);
+
+                    DPDK_INST_UPDATE_METRIC(callbackDuration, ts_D - ts_C);
+                    DPDK_INST_UPDATE_METRIC(packetFreeDuration, ts_E - ts_D);
+
+                    count += num_rx;
+                    continue;
+                }
+
                 for (j = 0; j < PREFETCH_OFFSET && j < num_rx; j++) {
                     rte_prefetch0(rte_pktmbuf_mtod(pkts_burst[j], void *));
                 }
@@ -135,6 +135,7 @@ int streams_operator_init(int lcoreMaster, int lcore, int nicPort, int nicQueue,
                 lcore_conf_[lcore_id].rx_queue_list[rxq].queue_id = 0;
                 lcore_conf_[lcore_id].rx_queue_list[rxq].userData = NULL;
                 lcore_conf_[lcore_id].rx_queue_list[rxq].packetCallbackFunction = NULL;
+                lcore_conf_[lcore_id].rx_queue_list[rxq].burstCallbackFunction = NULL;
             }
         }
 
@@ -189,6 +190,7 @@ int streams_operator_init(int lcoreMaster, int lcore, int nicPort, int nicQueue,
     lcore_conf_[lcore].rx_queue_list[coreQueue].queue_id = nicQueue;
     lcore_conf_[lcore].rx_queue_list[coreQueue].userData = user;
     lcore_conf_[lcore].rx_queue_list[coreQueue].packetCallbackFunction = dpdkCallback;
+    lcore_conf_[lcore].rx_queue_list[coreQueue].burstCallbackFunction = NULL;
     lcore_conf_[lcore].num_rx_queue += 1;
     if(lcore_conf_[lcore].num_rx_queue == MAX_RX_QUEUE_PER_LCORE) {
         printf("STREAMS_SOURCE: Error - Invalid number of queues on lcore %d, only %d can be defined.\n", lcore, MAX_RX_QUEUE_PER_LCORE);
@@ -225,6 +227,40 @@ int streams_operator_init(int lcoreMaster, int lcore, int nicPort, int nicQueue,
     return(0); 
 }
 
+/*
+ * This function may be called by a Streams PacketDPDKSource operator in its constructor,
+ * after streams_operator_init(), to receive each burst of packets from its NIC queue in one
+ * call, rather than one call per packet.
+ *
+ *    callback : Pointer to the Streams operator function to call for each burst of packets.
+ *
+ *  Return Values: 0 on success, -1 if the queue was not initialized on the lcore.
+ *
+ */
+int streams_operator_set_burst_callback(int lcore, int nicPort, int nicQueue,
+                                        streams_burst_cb_t callback) {
+
+    if(lcore < 0 || lcore >= RTE_MAX_LCORE) return(-1);
+
+    pthread_mutex_lock(&mutexInit);
+    unsigned rxq;
+    for(rxq = 0; rxq < lcore_conf_[lcore].num_rx_queue; rxq++) {
+        struct rx_queue *queue = &lcore_conf_[lcore].rx_queue_list[rxq];
+        if(queue->port_id == nicPort && queue->queue_id == nicQueue) {
+            queue->burstCallbackFunction = callback;
+            printf("STREAMS_SOURCE: lcore = %d, nicPort = %d, nicQueue = %d, burst callback = 0x%lx.\n",
+                lcore, nicPort, nicQueue, callback);
+            pthread_mutex_unlock(&mutexInit);
+            return(0);
+        }
+    }
+    pthread_mutex_unlock(&mutexInit);
+
+    printf("STREAMS_SOURCE: Error - nicPort %d, nicQueue %d not initialized on lcore %d.\n",
+        nicPort, nicQueue, lcore);
+    return(-1);
+}
+
 /*
  *  Initialize the DPDK library.
  */
@@ -376,3 +412,9 @@ uint64_t streams_source_get_tsc_hz(void) {
     return(rte_get_tsc_hz()); 
 }
 
+/*
+ * Return the NUMA node the NIC port is attached to, or -1 if it is not known.
+ */
+int streams_port_socket_id(int nicPort) {
+    return(rte_eth_dev_socket_id(nicPort));
+}
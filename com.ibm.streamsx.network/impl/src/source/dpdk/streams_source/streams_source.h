@@ -7,6 +7,8 @@
 #ifndef _STREAMS_SOURCE_H_
 #define _STREAMS_SOURCE_H_
 
+#include <sys/uio.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -20,9 +22,16 @@ extern "C" {
                   unsigned int len,
 	          uint64_t timestamp);
 
+    typedef void (*streams_burst_cb_t)(void * user, const struct iovec *packets,
+                  unsigned int count,
+                  uint64_t timestamp);
+
     int streams_operator_init(int lcoreMaster, int lcore, int nicPort, int nicQueue, 
                               int promiscuous, streams_packet_cb_t callback, void *user);
 
+    int streams_operator_set_burst_callback(int lcore, int nicPort, int nicQueue,
+                                            streams_burst_cb_t callback);
+
     int streams_dpdk_init(const char* buffersizes); 
 
     int streams_source_start(void);
@@ -32,6 +41,8 @@ extern "C" {
 
     int streams_port_stats(int, struct port_stats *);
 
+    int streams_port_socket_id(int nicPort);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,102 @@
+#!/bin/bash
+
+## Copyright (C) 2026  International Business Machines Corporation
+## All Rights Reserved
+
+################### parameters used in this script ##############################
+
+#set -o xtrace
+#set -o pipefail
+
+namespace=sample
+composite=LivePacketXDPSourceVeth
+
+here=$( cd ${0%/*} ; pwd )
+projectDirectory=$( cd $here/.. ; pwd )
+[[ -f $STREAMS_INSTALL/toolkits/com.ibm.streamsx.network/info.xml ]] && toolkitDirectory=$STREAMS_INSTALL/toolkits
+[[ -f $here/../../../../toolkits/com.ibm.streamsx.network/info.xml ]] && toolkitDirectory=$( cd $here/../../../../toolkits ; pwd )
+[[ -f $here/../../../com.ibm.streamsx.network/info.xml ]] && toolkitDirectory=$( cd $here/../../.. ; pwd )
+[[ $toolkitDirectory ]] || die "sorry, could not find 'toolkits' directory"
+
+buildDirectory=$projectDirectory/output/build/$composite
+
+dataDirectory=$projectDirectory/data
+
+pcapFile=$( cd $here/../../SampleNetworkToolkitData/data ; pwd )/sample_dns+dhcp.pcap
+
+networkInterface=xdp0
+peerInterface=xdp1
+
+coreCount=$( cat /proc/cpuinfo | grep processor | wc -l )
+
+toolkitList=(
+$toolkitDirectory/com.ibm.streamsx.network
+)
+
+compilerOptionsList=(
+--verbose-mode
+--rebuild-toolkits
+--spl-path=$( IFS=: ; echo "${toolkitList[*]}" )
+--standalone-application
+--optimized-code-generation
+--cxx-flags=-g3
+--static-link
+--main-composite=$namespace::$composite
+--output-directory=$buildDirectory 
+--data-directory=data
+--num-make-threads=$coreCount
+)
+
+compileTimeParameterList=(
+)
+
+submitParameterList=(
+networkInterface=$networkInterface
+expectedPackets=$( tcpdump -r $pcapFile 2>/dev/null | wc -l )
+timeoutInterval=20.0
+)
+
+traceLevel=3 # ... 0 for off, 1 for error, 2 for warn, 3 for info, 4 for debug, 5 for trace
+
+################### functions used in this script #############################
+
+die() { echo ; echo -e "\e[1;31m$*\e[0m" >&2 ; exit 1 ; }
+step() { echo ; echo -e "\e[1;34m$*\e[0m" ; }
+
+################################################################################
+
+cd $projectDirectory || die "Sorry, could not change to $projectDirectory, $?"
+
+[ -d $dataDirectory ] || mkdir -p $dataDirectory || die "Sorry, could not create '$dataDirectory, $?"
+[ -f $pcapFile ] || die "sorry, PCAP file '$pcapFile' not found"
+which tcpreplay 1>/dev/null 2>&1 || die "sorry, this script needs 'tcpreplay' to send packets"
+
+step "configuration for standalone application '$namespace.$composite' ..."
+( IFS=$'\n' ; echo -e "\nStreams toolkits:\n${toolkitList[*]}" )
+( IFS=$'\n' ; echo -e "\nStreams compiler options:\n${compilerOptionsList[*]}" )
+( IFS=$'\n' ; echo -e "\n$composite compile-time parameters:\n${compileTimeParameterList[*]}" )
+( IFS=$'\n' ; echo -e "\n$composite submission-time parameters:\n${submitParameterList[*]}" )
+echo -e "\ntrace level: $traceLevel"
+
+step "building standalone application '$namespace.$composite' ..."
+sc ${compilerOptionsList[*]} -- ${compileTimeParameterList[*]} || die "Sorry, could not build '$composite', $?" 
+
+step "creating virtual ethernet interfaces '$networkInterface' and '$peerInterface' with two queues each ..."
+sudo ip link del $networkInterface 1>/dev/null 2>&1
+sudo ip link add $networkInterface numrxqueues 2 numtxqueues 2 type veth peer name $peerInterface numrxqueues 2 numtxqueues 2 || die "sorry, could not create virtual ethernet interfaces, $?"
+trap "sudo ip link del $networkInterface" EXIT
+sudo ip link set $networkInterface up || die "sorry, could not enable '$networkInterface', $?"
+sudo ip link set $peerInterface up || die "sorry, could not enable '$peerInterface', $?"
+
+step "executing standalone application '$namespace.$composite' ..."
+executable=$buildDirectory/bin/standalone.exe
+sudo STREAMS_INSTALL=$STREAMS_INSTALL $executable -t $traceLevel ${submitParameterList[*]} &
+application=$!
+
+step "replaying '$pcapFile' into '$peerInterface' ..."
+sleep 5
+sudo tcpreplay --intf1=$peerInterface $pcapFile || die "sorry, could not replay '$pcapFile', $?"
+
+wait $application || die "sorry, application '$composite' failed, $?"
+
+exit 0